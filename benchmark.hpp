@@ -0,0 +1,251 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Minimal multi-threaded benchmark harness: every thread runs operations
+// drawn from a mix until the time is up, timing each one into a per-thread
+// latency histogram. Histograms are merged after the run.
+
+namespace hungbiu {
+
+namespace bench {
+
+typedef std::chrono::steady_clock clock_type;
+
+// Log-linear histogram of nanosecond latencies: 32 sub-buckets per power
+// of two, about 3% relative error, up to ~1 minute
+class latency_histogram
+{
+private:
+    static constexpr unsigned SubBits = 5;
+    static constexpr unsigned SubCount = 1u << SubBits;
+    static constexpr unsigned Powers = 36;
+
+    std::vector<uint64_t> m_buckets = std::vector<uint64_t>(Powers * SubCount);
+    uint64_t              m_count = 0;
+
+    static unsigned index_of(uint64_t ns) noexcept {
+        if (ns < SubCount) {
+            return static_cast<unsigned>(ns);
+        }
+        auto power = 63u - static_cast<unsigned>(__builtin_clzll(ns));    // >= SubBits
+        auto sub = static_cast<unsigned>(ns >> (power - SubBits)) & (SubCount - 1);
+        auto idx = (power - SubBits + 1) * SubCount + sub;
+        return idx < Powers * SubCount ? idx : Powers * SubCount - 1;
+    }
+    static uint64_t value_of(unsigned idx) noexcept {
+        if (idx < SubCount) {
+            return idx;
+        }
+        auto power = idx / SubCount - 1 + SubBits;
+        auto sub = idx % SubCount;
+        return (uint64_t{ SubCount } + sub) << (power - SubBits);
+    }
+public:
+    void record(uint64_t ns) noexcept {
+        ++m_buckets[index_of(ns)];
+        ++m_count;
+    }
+    void merge(const latency_histogram &oth) noexcept {
+        for (size_t i = 0; i < m_buckets.size(); ++i) {
+            m_buckets[i] += oth.m_buckets[i];
+        }
+        m_count += oth.m_count;
+    }
+    uint64_t count() const noexcept {
+        return m_count;
+    }
+    // Latency (ns) below which fraction q of the samples fall
+    uint64_t percentile(double q) const noexcept {
+        auto rank = static_cast<uint64_t>(q * m_count);
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < m_buckets.size(); ++i) {
+            seen += m_buckets[i];
+            if (seen > rank) {
+                return value_of(i);
+            }
+        }
+        return 0;
+    }
+};
+
+// Keep the compiler from discarding a computed value
+template<typename V>
+inline void do_not_optimize(const V &v) noexcept
+{
+    asm volatile("" : : "g"(v) : "memory");
+}
+
+// One operation of a mix: a name, a relative weight and the function to
+// run, called as fn(subject, rng, thread_index)
+template<typename Subject>
+struct operation
+{
+    const char *m_name;
+    unsigned    m_weight;
+    void (*m_fn)(Subject &, std::mt19937_64 &, unsigned);
+};
+
+template<typename Subject>
+struct mix
+{
+    const char                      *m_name;
+    std::vector<operation<Subject>>  m_ops;
+};
+
+struct op_result
+{
+    const char        *m_name;
+    latency_histogram  m_latency;
+};
+
+struct run_result
+{
+    double                 m_seconds = 0;
+    uint64_t               m_ops = 0;
+    std::vector<op_result> m_per_op;
+};
+
+// Run the mix on subject with threads threads for duration
+template<typename Subject>
+run_result run(Subject &subject, const mix<Subject> &m, unsigned threads, std::chrono::milliseconds duration)
+{
+    auto total_weight = 0u;
+    for (auto &op : m.m_ops) {
+        total_weight += op.m_weight;
+    }
+
+    auto start_flag = std::atomic<bool>{ false };
+    auto stop_flag = std::atomic<bool>{ false };
+    auto ready = std::atomic<unsigned>{ 0 };
+    auto per_thread = std::vector<std::vector<latency_histogram>>(threads,
+                          std::vector<latency_histogram>(m.m_ops.size()));
+
+    auto worker = [&](unsigned idx) {
+        auto rng = std::mt19937_64{ 0x9e3779b97f4a7c15ull * (idx + 1) };
+        auto &hist = per_thread[idx];
+        ready.fetch_add(1);
+        while (!start_flag.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        while (!stop_flag.load(std::memory_order_relaxed)) {
+            auto pick = static_cast<unsigned>(rng() % total_weight);
+            auto op = size_t{ 0 };
+            while (pick >= m.m_ops[op].m_weight) {
+                pick -= m.m_ops[op].m_weight;
+                ++op;
+            }
+            auto t0 = clock_type::now();
+            m.m_ops[op].m_fn(subject, rng, idx);
+            auto t1 = clock_type::now();
+            hist[op].record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+        }
+    };
+
+    auto pool = std::vector<std::thread>{};
+    for (auto i = 0u; i < threads; ++i) {
+        pool.emplace_back(worker, i);
+    }
+    while (ready.load() != threads) {
+        std::this_thread::yield();
+    }
+    auto t0 = clock_type::now();
+    start_flag.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(duration);
+    stop_flag.store(true, std::memory_order_relaxed);
+    for (auto &t : pool) {
+        t.join();
+    }
+    auto t1 = clock_type::now();
+
+    auto result = run_result{};
+    result.m_seconds = std::chrono::duration<double>(t1 - t0).count();
+    for (size_t op = 0; op < m.m_ops.size(); ++op) {
+        auto r = op_result{ m.m_ops[op].m_name, {} };
+        for (auto &h : per_thread) {
+            r.m_latency.merge(h[op]);
+        }
+        result.m_ops += r.m_latency.count();
+        result.m_per_op.push_back(std::move(r));
+    }
+    return result;
+}
+
+inline void print_header()
+{
+    printf( "%-36s %-14s %7s %12s  %-14s %8s %8s %8s\n",
+            "subject", "mix", "threads", "ops/s", "op", "p50(ns)", "p99(ns)", "p999(ns)" );
+}
+
+inline void print_result(const char *subject, const char *mix_name, unsigned threads, const run_result &r)
+{
+    auto first = true;
+    for (auto &op : r.m_per_op) {
+        if (first) {
+            printf("%-36s %-14s %7u %12.0f  ", subject, mix_name, threads, r.m_ops / r.m_seconds);
+            first = false;
+        } else {
+            printf("%-36s %-14s %7s %12s  ", "", "", "", "");
+        }
+        printf( "%-14s %8llu %8llu %8llu\n",
+                op.m_name,
+                static_cast<unsigned long long>(op.m_latency.percentile(0.50)),
+                static_cast<unsigned long long>(op.m_latency.percentile(0.99)),
+                static_cast<unsigned long long>(op.m_latency.percentile(0.999)) );
+    }
+    fflush(stdout);
+}
+
+// Command line: --threads N --duration MS --mix NAME --subject NAME
+struct options
+{
+    unsigned                  m_threads = std::thread::hardware_concurrency();
+    std::chrono::milliseconds m_duration{ 500 };
+    std::string               m_mix;        // Empty selects all
+    std::string               m_subject;    // Substring filter, empty selects all
+
+    options(int argc, char **argv) {
+        for (auto i = 1; i + 1 < argc; i += 2) {
+            if (!strcmp(argv[i], "--threads")) {
+                m_threads = static_cast<unsigned>(atoi(argv[i + 1]));
+            } else if (!strcmp(argv[i], "--duration")) {
+                m_duration = std::chrono::milliseconds{ atoi(argv[i + 1]) };
+            } else if (!strcmp(argv[i], "--mix")) {
+                m_mix = argv[i + 1];
+            } else if (!strcmp(argv[i], "--subject")) {
+                m_subject = argv[i + 1];
+            }
+        }
+        if (!m_threads) {
+            m_threads = 1;
+        }
+    }
+    bool wants_mix(const char *name) const {
+        return m_mix.empty() || m_mix == name;
+    }
+    bool wants_subject(const char *name) const {
+        return m_subject.empty() || std::string{ name }.find(m_subject) != std::string::npos;
+    }
+    // 1, 2, 4, ... up to m_threads
+    std::vector<unsigned> thread_counts() const {
+        auto counts = std::vector<unsigned>{};
+        for (auto n = 1u; n < m_threads; n *= 2) {
+            counts.push_back(n);
+        }
+        counts.push_back(m_threads);
+        return counts;
+    }
+};
+
+} // end of namespace bench
+
+}; // end of namespace hungbiu
@@ -0,0 +1,248 @@
+#pragma once
+#include <type_traits>
+#include <memory>
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <iterator>
+#include <new>
+#include "cache_line.hpp"
+
+namespace hungbiu {
+
+// A bounded multi-producer multi-consumer FIFO queue on a ring of slots,
+// after Vyukov: each slot carries a sequence number telling which lap of
+// the ring it is ready for. A producer claims position pos by CAS on the
+// tail once the slot's sequence equals pos, constructs the element and
+// publishes it with sequence pos + 1; a consumer claims pos by CAS on the
+// head once the sequence is pos + 1, and frees the slot for the next lap
+// with sequence pos + capacity.
+//
+// Nothing is allocated after construction. try_push/try_pop fail instead
+// of waiting when the queue is full/empty; they are lock-free, though an
+// operation can only complete once the one claiming the previous lap of
+// the same slot has.
+//
+// The batch variants claim a run of consecutive ready slots with a single
+// CAS, so their elements are contiguous in the queue order.
+//
+// A claimed slot must be filled, so an element is only constructed in its
+// slot if that cannot throw; otherwise it is built first and moved in.
+template<typename T, typename Allocator = std::allocator<T>>
+class bounded_mpmc_queue
+{
+public:
+    typedef T           value_type;
+    typedef Allocator   allocator_type;
+private:
+    static constexpr size_t CacheLine = detail::cache_line_size;
+
+    struct slot
+    {
+        std::atomic<size_t> m_seq;
+        alignas(T) unsigned char m_storage[sizeof(T)];
+
+        T *value() noexcept {
+            return std::launder(reinterpret_cast<T *>(m_storage));
+        }
+    };
+    static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_destructible_v<T>,
+                  "bounded_mpmc_queue requires elements that move and destroy without throwing");
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<slot> slot_allocator;
+    typedef std::allocator_traits<slot_allocator>                                    slot_alloc_traits;
+
+    // Producers and consumers write on separate cache lines
+    alignas(CacheLine) std::atomic<size_t> m_tail;
+    alignas(CacheLine) std::atomic<size_t> m_head;
+    alignas(CacheLine) slot               *m_slots;
+    size_t                                 m_mask;
+    slot_allocator                         m_alloc;
+
+    static size_t round_up(size_t capacity) {
+        if (capacity == 0 || capacity > (~size_t{ 0 } >> 2)) {
+            throw std::runtime_error{ "bounded_mpmc_queue: invalid capacity" };
+        }
+        auto n = size_t{ 1 };
+        while (n < capacity) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    // Claims up to max consecutive slots, from the position on the
+    // counter c whose slot sequence is ready + lap offset. Returns the
+    // first position claimed and the count in n.
+    size_t claim(std::atomic<size_t> &c, size_t ready, size_t max, size_t &n) noexcept {
+        auto pos = c.load(std::memory_order_relaxed);
+        for (;;) {
+            n = 0;
+            while (n < max) {
+                auto seq = m_slots[(pos + n) & m_mask].m_seq.load(std::memory_order_acquire);
+                if (seq != pos + n + ready) {
+                    break;
+                }
+                ++n;
+            }
+            if (n == 0) {
+                // Not ready: either c moved on or the queue is full/empty
+                auto seq = m_slots[pos & m_mask].m_seq.load(std::memory_order_acquire);
+                auto now = c.load(std::memory_order_relaxed);
+                if (now == pos && static_cast<std::make_signed_t<size_t>>(seq - (pos + ready)) < 0) {
+                    return pos;
+                }
+                pos = now;
+                continue;
+            }
+            if (c.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                return pos;
+            }
+        }
+    }
+    void publish(size_t pos) noexcept {
+        m_slots[pos & m_mask].m_seq.store(pos + 1, std::memory_order_release);
+    }
+    void release(size_t pos) noexcept {
+        m_slots[pos & m_mask].m_seq.store(pos + m_mask + 1, std::memory_order_release);
+    }
+public:
+    // Constructor: capacity is rounded up to a power of 2
+    explicit bounded_mpmc_queue(size_t capacity, const Allocator &alloc = Allocator{}) :
+        m_tail(0), m_head(0), m_slots(nullptr), m_mask(round_up(capacity) - 1), m_alloc(alloc)
+    {
+        m_slots = slot_alloc_traits::allocate(m_alloc, m_mask + 1);
+        for (size_t i = 0; i <= m_mask; ++i) {
+            ::new (static_cast<void *>(m_slots + i)) slot;
+            m_slots[i].m_seq.store(i, std::memory_order_relaxed);
+        }
+    }
+    bounded_mpmc_queue(const bounded_mpmc_queue &) = delete;
+    bounded_mpmc_queue &operator= (const bounded_mpmc_queue &) = delete;
+
+    // Destructor: not thread-safe
+    ~bounded_mpmc_queue() {
+        auto head = m_head.load(std::memory_order_relaxed);
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        for (; head != tail; ++head) {
+            m_slots[head & m_mask].value()->~T();
+        }
+        for (size_t i = 0; i <= m_mask; ++i) {
+            m_slots[i].~slot();
+        }
+        slot_alloc_traits::deallocate(m_alloc, m_slots, m_mask + 1);
+    }
+
+    // Returns false if the queue is full
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        if constexpr (!std::is_nothrow_constructible_v<T, Args&&...>) {
+            return try_emplace(T(std::forward<Args>(args)...));
+        } else {
+            size_t n;
+            auto pos = claim(m_tail, 0, 1, n);
+            if (n == 0) {
+                return false;
+            }
+            ::new (static_cast<void *>(m_slots[pos & m_mask].m_storage)) T(std::forward<Args>(args)...);
+            publish(pos);
+            return true;
+        }
+    }
+    bool try_push(const T &val) {
+        return try_emplace(val);
+    }
+    bool try_push(T &&val) {
+        return try_emplace(std::move(val));
+    }
+
+    // Returns false if the queue is empty
+    bool try_pop(T &out) {
+        size_t n;
+        auto pos = claim(m_head, 1, 1, n);
+        if (n == 0) {
+            return false;
+        }
+        auto p = m_slots[pos & m_mask].value();
+        auto val = T(std::move(*p));
+        p->~T();
+        release(pos);
+        out = std::move(val);
+        return true;
+    }
+    std::optional<T> try_pop() {
+        size_t n;
+        auto pos = claim(m_head, 1, 1, n);
+        if (n == 0) {
+            return std::nullopt;
+        }
+        auto p = m_slots[pos & m_mask].value();
+        auto ret = std::optional<T>{ std::move(*p) };
+        p->~T();
+        release(pos);
+        return ret;
+    }
+
+    // Pushes a prefix of [first, last), as much as there is room for.
+    // Returns the iterator past the last element pushed.
+    template<typename ForwardIt>
+    ForwardIt try_push_range(ForwardIt first, ForwardIt last) {
+        typedef typename std::iterator_traits<ForwardIt>::reference reference;
+        if constexpr (!std::is_nothrow_constructible_v<T, reference>) {
+            for (; first != last && try_emplace(*first); ++first) {}
+        } else {
+            while (first != last) {
+                size_t n;
+                auto pos = claim(m_tail, 0, static_cast<size_t>(std::distance(first, last)), n);
+                if (n == 0) {
+                    break;
+                }
+                for (auto end = pos + n; pos != end; ++pos, ++first) {
+                    ::new (static_cast<void *>(m_slots[pos & m_mask].m_storage)) T(*first);
+                    publish(pos);
+                }
+            }
+        }
+        return first;
+    }
+
+    // Pops up to max elements into out. Returns the number popped.
+    template<typename OutputIt>
+    size_t try_pop_n(OutputIt out, size_t max) {
+        auto count = size_t{ 0 };
+        while (count < max) {
+            size_t n;
+            auto pos = claim(m_head, 1, max - count, n);
+            if (n == 0) {
+                break;
+            }
+            for (auto end = pos + n; pos != end; ++pos, ++out) {
+                auto p = m_slots[pos & m_mask].value();
+                auto val = T(std::move(*p));
+                p->~T();
+                release(pos);
+                *out = std::move(val);
+            }
+            count += n;
+        }
+        return count;
+    }
+
+    // Approximate when operations race with it
+    size_t size() const noexcept {
+        auto head = m_head.load(std::memory_order_relaxed);
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+    size_t capacity() const noexcept {
+        return m_mask + 1;
+    }
+    allocator_type get_allocator() const noexcept {
+        return allocator_type{ m_alloc };
+    }
+};
+
+}; // end of namespace hungbiu
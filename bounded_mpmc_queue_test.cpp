@@ -0,0 +1,133 @@
+#include "bounded_mpmc_queue.hpp"
+#include <thread>
+#include <stdio.h>
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <vector>
+
+using namespace hungbiu;
+
+void test_single_thread()
+{
+    auto q = bounded_mpmc_queue<std::string>{ 5 };
+    assert(q.capacity() == 8 && q.empty());
+
+    // FIFO order, full and empty
+    for (auto i = 0; i < 8; ++i) {
+        assert(q.try_push(std::to_string(i)));
+    }
+    auto s = std::string{ "full" };
+    assert(!q.try_push(s) && !q.try_emplace(3, 'x'));
+    assert(q.size() == 8);
+    for (auto i = 0; i < 8; ++i) {
+        auto v = q.try_pop();
+        assert(v && *v == std::to_string(i));
+    }
+    assert(!q.try_pop() && !q.try_pop(s) && s == "full");
+    printf("try_push(), try_pop(): pass\n");
+
+    // Laps around the ring
+    for (auto i = 0; i < 100; ++i) {
+        assert(q.try_emplace(i, 'a'));
+        assert(q.try_pop(s) && s == std::string(i, 'a'));
+    }
+    printf("wrap around: pass\n");
+
+    // Batches, cut short by the capacity
+    auto iq = bounded_mpmc_queue<int>{ 16 };
+    auto in = std::vector<int>(20);
+    for (auto i = 0; i < 20; ++i) {
+        in[i] = i;
+    }
+    assert(iq.try_push_range(in.begin(), in.begin() + 10) == in.begin() + 10);
+    assert(iq.try_push_range(in.begin() + 10, in.end()) == in.begin() + 16);
+    auto out = std::vector<int>(20, -1);
+    assert(iq.try_pop_n(out.begin(), 4) == 4);
+    assert(iq.try_pop_n(out.begin() + 4, 20) == 12);
+    assert(iq.try_pop_n(out.begin(), 20) == 0);
+    for (auto i = 0; i < 16; ++i) {
+        assert(out[i] == i);
+    }
+    printf("try_push_range(), try_pop_n(): pass\n");
+
+    // The destructor destroys what is left
+    auto sq = bounded_mpmc_queue<std::string>{ 4 };
+    sq.try_push(std::string(100, 'x'));
+    sq.try_push(std::string(100, 'y'));
+    sq.try_pop_n(&s, 1);
+    assert(s == std::string(100, 'x'));
+    printf("destructor: pass\n");
+}
+
+void test_multi_thread()
+{
+    // Every value pushed is popped exactly once, and each producer's
+    // values come out in the order it pushed them
+    constexpr auto Producers = 3;
+    constexpr auto Consumers = 3;
+    constexpr auto PerProducer = 100000;
+    auto q = bounded_mpmc_queue<long>{ 64 };
+    std::atomic<long> sum{ 0 };
+    std::atomic<int> popped{ 0 };
+    auto producer = [&q](int id) {
+        auto batch = std::vector<long>(8);
+        for (auto i = 0; i < PerProducer;) {
+            if (i % 3 == 0) {
+                auto n = std::min<int>(8, PerProducer - i);
+                for (auto k = 0; k < n; ++k) {
+                    batch[k] = static_cast<long>(i + k) * Producers + id;
+                }
+                auto end = q.try_push_range(batch.begin(), batch.begin() + n);
+                i += static_cast<int>(end - batch.begin());
+            } else if (q.try_push(static_cast<long>(i) * Producers + id)) {
+                ++i;
+            }
+            if (i % 64 == 0) {
+                std::this_thread::yield();
+            }
+        }
+    };
+    auto consumer = [&] {
+        auto last = std::vector<long>(Producers, -1);
+        auto buf = std::vector<long>(8);
+        auto check = [&](long v) {
+            auto id = v % Producers;
+            assert(v / Producers > last[id]);
+            last[id] = v / Producers;
+            sum += v;
+        };
+        while (popped.load() < Producers * PerProducer) {
+            auto n = q.try_pop_n(buf.begin(), buf.size());
+            for (size_t k = 0; k < n; ++k) {
+                check(buf[k]);
+            }
+            auto v = long{};
+            if (q.try_pop(v)) {
+                check(v);
+                ++n;
+            }
+            popped += static_cast<int>(n);
+        }
+    };
+    auto threads = std::vector<std::thread>{};
+    for (auto id = 0; id < Producers; ++id) {
+        threads.emplace_back(producer, id);
+    }
+    for (auto i = 0; i < Consumers; ++i) {
+        threads.emplace_back(consumer);
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    const long total = static_cast<long>(Producers) * PerProducer;
+    assert(popped.load() == total && q.empty());
+    assert(sum.load() == total * (total - 1) / 2);
+    printf("simultaneous producers and consumers: pass\n");
+}
+
+int main()
+{
+    test_single_thread();
+    test_multi_thread();
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <new>
+
+namespace hungbiu {
+
+namespace detail {
+
+// The alignment that keeps two objects from sharing a cache line, for
+// the hot atomics of this library. The standard constant depends on the
+// tuning flags (GCC warns about its use in headers for that reason), so
+// every translation unit including these headers must agree on them.
+#if defined(__cpp_lib_hardware_interference_size)
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+inline constexpr size_t cache_line_size = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic pop
+#endif
+#else
+inline constexpr size_t cache_line_size = 64;
+#endif
+
+// Hint that the cache line at p is read soon. A prefetch never faults,
+// so p may point at memory that is already freed.
+inline void prefetch(const void *p) noexcept
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(p, 0, 3);
+#else
+    (void)p;
+#endif
+}
+
+} // end of namespace detail
+
+}; // end of namespace hungbiu
@@ -1,38 +1,108 @@
 #pragma once
-#include <type_traits> // to be finished
+#include <type_traits>
 #include <memory>
 #include <atomic>
-#include <mutex>
+#include <mutex>  // std::unique_lock
+#include <chrono>
 #include <stdexcept>
+#include <cstring>
+#include <optional>
+#include <utility>
+#include <iterator>
+#include <vector>
+#include "reclamation.hpp"
+#include "tagged_link.hpp"
+#include "list_traversal.hpp"
+#include "elimination_array.hpp"
+#include "striped_counter.hpp"
+#include "list_stats.hpp"
+#include "cache_line.hpp"
+#include "version_stamps.hpp"
+#include "waiter_list.hpp"
 
 namespace hungbiu {
 
-template<typename T>
+// Synchronization policies of concurrent_forward_list
+// insert_after/erase_after/pop_front take per-node spinlocks
+struct locking_policy {};
+// insert_after/erase_after/pop_front are lock-free: an erased node is first
+// marked in its link (Harris), then unlinked by CAS on its predecessor, and
+// any operation running into a marked node helps to unlink it
+struct lock_free_policy {};
+
+// Node layouts of concurrent_forward_list
+// The link word and the value share the node's cache line
+struct compact_layout {};
+// The link word and the value each start a cache line of their own, so
+// lock and mark writes on the link do not invalidate the line holding
+// the value, at the cost of a node spanning at least two cache lines
+struct split_layout {};
+
+// Node versioning of concurrent_forward_list
+// Nodes carry nothing but the link and the value
+struct unversioned_nodes {};
+// Nodes also carry birth and death stamps (version_stamps.hpp), which
+// snapshot() needs to pick the elements present at one point in time
+struct versioned_nodes {};
+
+// Where clear() and the destructor release the nodes they take out: on the
+// calling thread, or on the background_reclaimer thread (reclamation.hpp),
+// which leaves the calling thread with a single exchange on the head
+enum class teardown { caller, background };
+
+// How push_front/pop_front handle a lost CAS on the head: back off
+// exponentially and retry, or first try to meet an opposite operation in
+// an elimination array (elimination_array.hpp), then back off
+enum class contention { backoff, elimination };
+
+// Reclaimer decides when unlinked nodes are freed, see reclamation.hpp.
+// Nodes are linked by raw pointers; a node leaving the list is retired to
+// the Reclaimer and freed once no guard (held by iterators and operations)
+// can reach it.
+// Allocator must be stateless (is_always_equal), since retired nodes are
+// freed without access to the list; node_pool_allocator (node_pool.hpp)
+// recycles node storage without going to the global heap.
+// SyncPolicy is locking_policy or lock_free_policy, see above.
+// Stats receives the contention the modifiers run into, see
+// list_stats.hpp: no_stats compiles it away, thread_stats counts it.
+// Layout is compact_layout or split_layout, see above.
+// Versioning is unversioned_nodes or versioned_nodes, see above.
+template<typename T, 
+         typename Reclaimer = epoch_reclaimer, 
+         typename Allocator = std::allocator<T>,
+         typename SyncPolicy = locking_policy,
+         typename Stats = no_stats,
+         typename Layout = compact_layout,
+         typename Versioning = unversioned_nodes>
 class concurrent_forward_list
 {
 private:
-    struct list_node
+    static constexpr bool is_split_layout = std::is_same_v<Layout, split_layout>;
+    static_assert( is_split_layout || std::is_same_v<Layout, compact_layout>,
+                   "Layout must be compact_layout or split_layout" );
+    static constexpr bool is_versioned = std::is_same_v<Versioning, versioned_nodes>;
+    static_assert( is_versioned || std::is_same_v<Versioning, unversioned_nodes>,
+                   "Versioning must be unversioned_nodes or versioned_nodes" );
+
+    struct list_node : detail::version_stamps<is_versioned>
     {
-        typedef std::shared_ptr<list_node>    pointer;
-        typedef std::mutex                    mutex_t;
-        typedef std::unique_lock<mutex_t>     unique_lock_t;
-        typedef std::atomic<bool>             flag_t;
+        typedef list_node*                    pointer;
+        typedef detail::tagged_link<list_node> link_t;
+        typedef std::unique_lock<link_t>      unique_lock_t;
 
         // Data members 
+        // The lock bit and the deleted mark live in the link word, so a
+        // node is one word plus the value (plus the stamps if versioned)
+        alignas(is_split_layout ? detail::cache_line_size : alignof(link_t))
+        mutable link_t  m_link;
+        alignas(is_split_layout ? detail::cache_line_size : alignof(T))
         T               m_val;
-        mutable mutex_t m_mtx;
-        mutable flag_t  m_deleted;
-        pointer         m_next;
 
         // Constructor
-        list_node() :                   // Default construct. Use case: end() and cend()
-            m_deleted(true) {}               
-        list_node(const T &val) :       // Specify val. Use case: insert_after()
-            m_val(val), m_deleted(false) {}
-        list_node(const pointer &p) :   // Specify pointer. Use case: before_begin()
-            m_next(p), m_deleted(true) {}
-        list_node(const T &val, const pointer &p) : // Specify val and pointer. Use case: push()
-            m_val(val), m_deleted(false), m_next(p) {}
+        // Specify the successor and construct the value in place from args
+        template<typename... Args>
+        explicit list_node(pointer p, Args&&... args) :
+            m_link(p), m_val(std::forward<Args>(args)...) {}
         list_node(const list_node &) = delete;
         list_node &operator= (const list_node &) = delete;
         ~list_node() = default;
@@ -41,66 +111,128 @@ private:
         // Acquire a RAII lock on the node
         unique_lock_t lock() const noexcept
         {
-            return unique_lock_t{ m_mtx };
+            return unique_lock_t{ m_link };
         }        
         // Test if the node is deleted
         bool is_deleted() const noexcept
         {
-            return m_deleted.load(std::memory_order_acquire);
+            return m_link.is_deleted();
         }
-        // Try to mark the node as deleted. Return true only if m_deleted was false.
+        // Try to mark the node as deleted. Return true only if it was not marked.
+        // The lock must be held.
         bool mark_as_deleted() noexcept
         {
-            auto b = false;
-            return m_deleted.compare_exchange_strong(b, true);
+            return m_link.mark_as_deleted();
+        }
+        // Load the successor
+        pointer next() const noexcept
+        {
+            return m_link.next();
         }
-
-
     };   
 private:
     typedef list_node                   node_type;
     typedef typename list_node::pointer pointer;
-    typedef typename list_node::mutex_t mutex_t;
+    typedef typename list_node::link_t  link_t;
+    typedef typename Reclaimer::guard   guard_t;
+    typedef typename link_t::word_t     word_t;
+    typedef detail::list_traversal<list_node, Reclaimer> traversal;
+
+    static constexpr bool is_lock_free = std::is_same_v<SyncPolicy, lock_free_policy>;
+    static_assert( is_lock_free || std::is_same_v<SyncPolicy, locking_policy>,
+                   "SyncPolicy must be locking_policy or lock_free_policy" );
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<node_type> node_allocator;
+    typedef std::allocator_traits<node_allocator>                                       node_alloc_traits;
+    static_assert( node_alloc_traits::is_always_equal::value, 
+                   "retired nodes are freed with a default-constructed allocator" );
+
+    // Owns a privately built run of nodes until it is published.
+    // Only the nodes up to m_last are owned, its link may already
+    // point into the list while a splice is being retried.
+    struct node_chain
+    {
+        pointer m_first = nullptr;
+        pointer m_last = nullptr;
+        size_t  m_count = 0;
+
+        node_chain() = default;
+        explicit node_chain(pointer p) noexcept :
+            m_first(p), m_last(p), m_count(1) {}
+        node_chain(node_chain &&oth) noexcept :
+            m_first(oth.m_first), m_last(oth.m_last), m_count(oth.m_count) {
+            oth.release();
+        }
+        node_chain(const node_chain &) = delete;
+        node_chain &operator= (const node_chain &) = delete;
+        ~node_chain() {
+            for (auto p = m_first; p; ) {
+                auto next = p == m_last ? nullptr : p->next();
+                concurrent_forward_list::destroy_node(p);
+                p = next;
+            }
+        }
+
+        bool empty() const noexcept {
+            return !m_first;
+        }
+        // Append a node created with no successor
+        void push_back(pointer p) noexcept {
+            if (m_last) {
+                m_last->m_link.init(p);
+            } else {
+                m_first = p;
+            }
+            m_last = p;
+            ++m_count;
+        }
+        // Called once the chain is published
+        void release() noexcept {
+            m_first = m_last = nullptr;
+            m_count = 0;
+        }
+    };
 
 public:    
     // Modifying the value of a node using an iterator
     // is NOT thread-safe. Users should not use the same 
     // iterator across different threads.
+    // An iterator holds a Reclaimer guard, so the node it 
+    // points to stays allocated even after being erased.
 template<typename Type>
 class concurrent_forward_list_iterator 
 {
     public:    
         typedef Type                          value_type;
-        typedef std::shared_ptr<list_node>    pointer;
+        typedef list_node*                    pointer;
         typedef value_type&                   reference;
         typedef const value_type&             const_reference;
         typedef value_type*                   raw_pointer;
         typedef const value_type*             const_raw_pointer;
     private:
-        pointer m_node_ptr;
+        pointer m_node_ptr = nullptr;
+        guard_t m_guard;    // Protects *m_node_ptr
     public:
     // Constructor
     concurrent_forward_list_iterator() noexcept {}    
-    concurrent_forward_list_iterator(const pointer &node_ptr) :
-        m_node_ptr(node_ptr) {}
-    concurrent_forward_list_iterator(pointer &&node_ptr) :
-        m_node_ptr(std::move(node_ptr)) {}
     concurrent_forward_list_iterator(const concurrent_forward_list_iterator &oth) :
-        m_node_ptr(oth.m_node_ptr) {}    
+        m_node_ptr(oth.m_node_ptr) { protect_copy(); }    
     template<typename U, 
              typename = std::enable_if_t<std::is_same_v< Type, 
                                                          std::add_const_t<U>> > 
                                         >    
     concurrent_forward_list_iterator(const concurrent_forward_list_iterator<U> &oth) :
-        m_node_ptr(oth.m_node_ptr) {}    
+        m_node_ptr(oth.m_node_ptr) { protect_copy(); }    
     concurrent_forward_list_iterator(concurrent_forward_list_iterator &&oth) noexcept :
-        m_node_ptr(std::move(oth.m_node_ptr)) {}
+        m_node_ptr(std::exchange(oth.m_node_ptr, nullptr)), 
+        m_guard(std::move(oth.m_guard)) {}
     template<typename U, 
              typename = std::enable_if_t<std::is_same_v< Type, 
                                                          std::add_const_t<U>> > 
                                         >    
-    concurrent_forward_list_iterator(concurrent_forward_list_iterator<U> &&oth) :
-        m_node_ptr(std::move(oth.m_node_ptr)) {}    
+    concurrent_forward_list_iterator(concurrent_forward_list_iterator<U> &&oth) noexcept :
+        m_node_ptr(std::exchange(oth.m_node_ptr, nullptr)), 
+        m_guard(std::move(oth.m_guard)) {}    
     ~concurrent_forward_list_iterator() = default;
 
     // Assignment operator
@@ -108,13 +240,15 @@ class concurrent_forward_list_iterator
     operator= (const concurrent_forward_list_iterator &rhs) {
         if (this != &rhs) {
             m_node_ptr = rhs.m_node_ptr;
+            protect_copy();
         }
         return *this;
     }        
     concurrent_forward_list_iterator& 
     operator= (concurrent_forward_list_iterator &&rhs) noexcept {
         if (this != &rhs) {
-            m_node_ptr = move(rhs.m_node_ptr);
+            m_node_ptr = std::exchange(rhs.m_node_ptr, nullptr);
+            m_guard = std::move(rhs.m_guard);
         }
         return *this;
     }
@@ -133,7 +267,6 @@ class concurrent_forward_list_iterator
 
     // Test if the iterator points to a position that is present in the list
     bool is_valid() const noexcept{
-        auto p = std::atomic_load_explicit(&m_node_ptr, std::memory_order_acquire);
         return m_node_ptr && 
                !m_node_ptr->is_deleted();
     }
@@ -159,43 +292,293 @@ class concurrent_forward_list_iterator
     // Pre-increment
     concurrent_forward_list_iterator &operator++ () 
     {     
-        m_node_ptr = m_node_ptr.get()->m_next;
+        m_node_ptr = concurrent_forward_list::advance(m_node_ptr, m_guard);
         return *this;
     }
     // Post-increment    
     concurrent_forward_list_iterator operator++ (int) {
         auto tmp_iter = *this;
-        m_node_ptr = m_node_ptr->m_next;
+        m_node_ptr = concurrent_forward_list::advance(m_node_ptr, m_guard);
         return tmp_iter;
     }
 
+private:
+    // Take over a node protected by g
+    concurrent_forward_list_iterator(pointer node_ptr, guard_t &&g) noexcept :
+        m_node_ptr(node_ptr), m_guard(std::move(g)) {}
+    // m_node_ptr is protected by the iterator copied from,
+    // so it can't be reclaimed before our guard is set
+    void protect_copy() {
+        if (m_node_ptr) {
+            m_guard.set(m_node_ptr);
+        } else {
+            m_guard.reset();
+        }
+    }
+
     friend class concurrent_forward_list;
-    friend class concurrent_forward_list<std::remove_cv_t<Type>>;
+    friend class concurrent_forward_list<std::remove_cv_t<Type>, Reclaimer, Allocator, SyncPolicy, Stats, Layout, Versioning>;
+    template<typename> friend class concurrent_forward_list_iterator;
 };
     typedef T                                         value_type;    
+    typedef Allocator                                 allocator_type;
+    typedef Stats                                     stats_type;
     typedef concurrent_forward_list_iterator<T>       iterator;
     typedef concurrent_forward_list_iterator<const T> const_iterator;
+
+    // The storage of one element
+    static constexpr size_t node_size = sizeof(node_type);
+
+    // The elements taken out of a list by take_all(), in list order.
+    // It belongs to one thread and is iterated and destroyed without
+    // synchronization. Other threads may still hold iterators to the
+    // nodes, which are therefore retired rather than freed.
+class detached_list
+{
+    public:
+    template<typename Type>
+    class detached_iterator
+    {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef std::remove_cv_t<Type>    value_type;
+            typedef std::ptrdiff_t            difference_type;
+            typedef Type*                     pointer;
+            typedef Type&                     reference;
+        private:
+            list_node *m_node_ptr = nullptr;
+            list_node *m_last = nullptr;
+        public:
+        detached_iterator() noexcept {}
+        template<typename U, 
+                 typename = std::enable_if_t<std::is_same_v< Type, 
+                                                             std::add_const_t<U>> > 
+                                            >    
+        detached_iterator(const detached_iterator<U> &oth) noexcept :
+            m_node_ptr(oth.m_node_ptr), m_last(oth.m_last) {}
+
+        friend bool operator==(const detached_iterator &lhs, const detached_iterator &rhs) noexcept {
+            return lhs.m_node_ptr == rhs.m_node_ptr;
+        }
+        friend bool operator!=(const detached_iterator &lhs, const detached_iterator &rhs) noexcept {
+            return lhs.m_node_ptr != rhs.m_node_ptr;
+        }
+        reference operator* () const noexcept {
+            return m_node_ptr->m_val;
+        }
+        pointer operator-> () const noexcept {
+            return &(m_node_ptr->m_val);
+        }
+        detached_iterator &operator++ () noexcept {
+            m_node_ptr = m_node_ptr == m_last ? nullptr : m_node_ptr->next();
+            return *this;
+        }
+        detached_iterator operator++ (int) noexcept {
+            auto tmp_iter = *this;
+            ++*this;
+            return tmp_iter;
+        }
+    private:
+        detached_iterator(list_node *p, list_node *last) noexcept :
+            m_node_ptr(p), m_last(last) {}
+
+        friend class detached_list;
+        template<typename> friend class detached_iterator;
+    };
+    typedef T                              value_type;
+    typedef detached_iterator<T>           iterator;
+    typedef detached_iterator<const T>     const_iterator;
+    private:
+        // Nodes are sealed, the links from m_first to m_last
+        // only change through this list
+        pointer m_first = nullptr;
+        pointer m_last = nullptr;
+    public:
+    detached_list() = default;
+    detached_list(detached_list &&oth) noexcept :
+        m_first(std::exchange(oth.m_first, nullptr)), 
+        m_last(std::exchange(oth.m_last, nullptr)) {}
+    detached_list &operator= (detached_list &&rhs) {
+        if (this != &rhs) {
+            clear();
+            m_first = std::exchange(rhs.m_first, nullptr);
+            m_last = std::exchange(rhs.m_last, nullptr);
+        }
+        return *this;
+    }
+    ~detached_list() {
+        clear();
+    }
+
+    iterator begin() noexcept {
+        return iterator{ m_first, m_last };
+    }
+    const_iterator begin() const noexcept {
+        return const_iterator{ m_first, m_last };
+    }
+    iterator end() noexcept {
+        return iterator{};
+    }
+    const_iterator end() const noexcept {
+        return const_iterator{};
+    }
+    bool empty() const noexcept {
+        return !m_first;
+    }
+    void clear() {
+        for (auto p = m_first; p; ) {
+            auto next = p == m_last ? nullptr : p->next();
+            retire_node(p);
+            p = next;
+        }
+        m_first = m_last = nullptr;
+    }
+    private:
+    // Append a sealed node
+    void push_back(pointer p) noexcept {
+        if (!m_last) {
+            m_first = p;
+        } else if (m_last->next() != p) {
+            relink_sealed(m_last, p);    // Skip erased nodes in between
+        }
+        m_last = p;
+    }
+
+    friend class concurrent_forward_list;
+};
+
+    // The elements of a list at one point in time, taken by snapshot().
+    // It is a copy, unaffected by later modifications of the list.
+class list_snapshot
+{
+    public:
+    typedef T                                          value_type;
+    typedef typename std::vector<T>::const_iterator    const_iterator;
+    private:
+        std::vector<T> m_values;
+        uint64_t       m_version = 0;
+    public:
+    list_snapshot() = default;
+
+    const_iterator begin() const noexcept {
+        return m_values.cbegin();
+    }
+    const_iterator end() const noexcept {
+        return m_values.cend();
+    }
+    bool empty() const noexcept {
+        return m_values.empty();
+    }
+    size_t size() const noexcept {
+        return m_values.size();
+    }
+    // Snapshots taken later have greater versions
+    uint64_t version() const noexcept {
+        return m_version;
+    }
+    private:
+    list_snapshot(std::vector<T> &&values, uint64_t version) noexcept :
+        m_values(std::move(values)), m_version(version) {}
+
+    friend class concurrent_forward_list;
+};
+
+#if HUNGBIU_COROUTINES
+    // What async_pop_front() returns: co_await yields the popped element,
+    // suspending the coroutine while the list is empty. The coroutine is
+    // resumed inside the push_front() call that woke it.
+class pop_awaiter
+{
+    private:
+        concurrent_forward_list     &m_list;
+        detail::waiter_list::waiter  m_waiter;
+        std::optional<T>             m_value;
+        std::coroutine_handle<>      m_handle;
+    public:
+    explicit pop_awaiter(concurrent_forward_list &list) noexcept :
+        m_list(list) {}
+    pop_awaiter(const pop_awaiter &) = delete;
+    pop_awaiter &operator= (const pop_awaiter &) = delete;
+
+    bool await_ready() {
+        return try_take();
+    }
+    bool await_suspend(std::coroutine_handle<> h) {
+        m_handle = h;
+        m_waiter.m_resume = &resume;
+        m_waiter.m_arg = this;
+        return !m_list.m_waiters.enqueue_unless(m_waiter, [this] { return try_take(); });
+    }
+    T await_resume() {
+        return std::move(*m_value);
+    }
+    private:
+    bool try_take() {
+        m_value = m_list.try_pop_front();
+        return m_value.has_value();
+    }
+    // On the notifying thread: take an element, or queue up again if
+    // someone else got it first
+    static void resume(void *p) {
+        auto self = static_cast<pop_awaiter *>(p);
+        if (self->m_list.m_waiters.enqueue_unless(self->m_waiter, [self] { return self->try_take(); })) {
+            self->m_handle.resume();
+        }
+    }
+};
+#endif
     
 private:
-    pointer m_head;
+    typedef detail::elimination_array<list_node> elimination_t;
+    typedef std::shared_ptr<detail::striped_counter> counter_ptr;
+
+    teardown                       m_teardown = teardown::caller;
+    std::unique_ptr<elimination_t> m_elimination;   // Only with contention::elimination
+    // Shared with the background_reclaimer while it clears for us
+    counter_ptr                    m_size = std::make_shared<detail::striped_counter>();
+    // Only with versioned_nodes
+    mutable detail::snapshot_state<is_versioned> m_snapshots;
+    // Consumers parked by wait_pop_front() and async_pop_front()
+    detail::waiter_list            m_waiters;
+    // Every push and pop CASes the head: it gets a cache line of its own,
+    // apart from the members above and from whatever lies next to the list
+    alignas(detail::cache_line_size) std::atomic<pointer> m_head{ nullptr };
 public:
     // Constructor
     concurrent_forward_list() = default;
+    explicit concurrent_forward_list(teardown mode) :
+        m_teardown(mode) {}
+    explicit concurrent_forward_list(contention c, teardown mode = teardown::caller) :
+        m_teardown(mode),
+        m_elimination(c == contention::elimination ? std::make_unique<elimination_t>() : nullptr) {}
     concurrent_forward_list(const concurrent_forward_list &) = delete;
-    ~concurrent_forward_list() = default;
+    // Not thread-safe: no other thread may access the list any more,
+    // nor wait on it
+    ~concurrent_forward_list() {
+        auto p = m_head.load(std::memory_order_acquire);
+        if (!p) {
+            return;
+        }
+        if (m_teardown == teardown::background) {
+            background_reclaimer::instance().defer(p, &destroy_chain);
+        } else {
+            destroy_chain(p);
+        }
+    }
     concurrent_forward_list &operator= (const concurrent_forward_list &) = delete;
     concurrent_forward_list &operator= (concurrent_forward_list &&) = delete;
 
     // Iterators
-    iterator begin() noexcept {
-        return iterator { 
-            std::atomic_load_explicit(&m_head, std::memory_order_acquire) 
-        };
+    // Nodes marked deleted but not unlinked yet are skipped
+    iterator begin() {
+        auto g = guard_t{};
+        auto p = first_live(g);
+        return iterator{ p, std::move(g) };
     }
-    const_iterator cbegin() const noexcept {
-        return const_iterator { 
-            std::atomic_load_explicit(&m_head, std::memory_order_acquire) 
-        };
+    const_iterator cbegin() const {
+        auto g = guard_t{};
+        auto p = first_live(g);
+        return const_iterator{ p, std::move(g) };
     }
     iterator end() noexcept {
         return iterator{};
@@ -204,102 +587,1182 @@ public:
         return const_iterator{};
     }
 
+    // Traversal
+    // Apply f to every element in list order, like iterating from begin()
+    // but under a single Reclaimer guard and without iterator copies.
+    // With epoch_reclaimer nothing is published per node; the whole
+    // walk is one read-side critical section, which holds back
+    // reclamation for as long as f runs.
+    template<typename F>
+    void for_each(F f) {
+        auto g = guard_t{};
+        traversal::visit_live(typename traversal::head_anchor{ m_head }, g,
+                              [&f](pointer p) { f(p->m_val); return true; });
+    }
+    template<typename F>
+    void for_each(F f) const {
+        auto g = guard_t{};
+        traversal::visit_live(typename traversal::head_anchor{ m_head }, g,
+                              [&f](pointer p) { f(std::as_const(p->m_val)); return true; });
+    }
+    // Apply f(const T *values, size_t n) to the elements in list order,
+    // in runs of up to Batch contiguous copies, e.g. for SIMD, under one
+    // Reclaimer guard like for_each(). Copying an element prefetches the
+    // node behind it (both of its lines with split_layout), so that miss
+    // overlaps with the copy and with f instead of stalling the next step.
+    // Trivially copyable values are copied into a buffer on the stack
+    // when the batch fits in BatchStackBytes.
+    static constexpr size_t DefaultBatch = 64;
+    static constexpr size_t BatchStackBytes = 4096;
+    template<size_t Batch = DefaultBatch, typename F>
+    void for_each_batch(F f) const {
+        static_assert( Batch > 0, "for_each_batch requires a positive Batch" );
+        static_assert( std::is_copy_constructible_v<T>,
+                       "for_each_batch requires copyable elements" );
+        auto g = guard_t{};
+        if constexpr (std::is_trivially_copyable_v<T> && Batch * sizeof(T) <= BatchStackBytes) {
+            alignas(T) unsigned char buf[Batch * sizeof(T)];
+            auto values = reinterpret_cast<T *>(buf);
+            auto n = size_t{ 0 };
+            visit_prefetching(g, [&](pointer p) {
+                std::memcpy(values + n, &p->m_val, sizeof(T));
+                if (++n == Batch) {
+                    f(std::as_const(values), n);
+                    n = 0;
+                }
+            });
+            if (n) {
+                f(std::as_const(values), n);
+            }
+        } else {
+            auto values = std::vector<T>{};
+            values.reserve(Batch);
+            visit_prefetching(g, [&](pointer p) {
+                values.push_back(p->m_val);
+                if (values.size() == Batch) {
+                    f(std::as_const(values).data(), values.size());
+                    values.clear();
+                }
+            });
+            if (!values.empty()) {
+                f(std::as_const(values).data(), values.size());
+            }
+        }
+    }
+    // Returns an iterator to the first element pred accepts, or end()
+    template<typename Pred>
+    iterator find_if(Pred pred) {
+        auto g = guard_t{};
+        auto p = traversal::visit_live(typename traversal::head_anchor{ m_head }, g,
+                                       [&pred](pointer p) { return !pred(p->m_val); });
+        return iterator{ p, std::move(g) };
+    }
+    template<typename Pred>
+    const_iterator find_if(Pred pred) const {
+        auto g = guard_t{};
+        auto p = traversal::visit_live(typename traversal::head_anchor{ m_head }, g,
+                                       [&pred](pointer p) { return !pred(std::as_const(p->m_val)); });
+        return const_iterator{ p, std::move(g) };
+    }
+
+    // Copy up to n elements, in list order, to out, under one Reclaimer
+    // guard like for_each().
+    // Returns the number of elements copied
+    size_t export_to(T *out, size_t n) const {
+        auto copied = size_t{ 0 };
+        if (!n) {
+            return copied;
+        }
+        auto g = guard_t{};
+        traversal::visit_live(typename traversal::head_anchor{ m_head }, g, [&](pointer p) {
+            out[copied] = p->m_val;
+            return ++copied < n;
+        });
+        return copied;
+    }
+
+    // Snapshot
+    // Copy the elements present at one point in time, without locks and
+    // without holding writers up. Every node is stamped from a version
+    // clock when it is created and when it is erased; the snapshot takes
+    // a version and copies the nodes born by then and not erased by then,
+    // including erased nodes other readers already skip. Insertions never
+    // disturb the walk. An erasure that unlinks a node meanwhile may hide
+    // it from the walk, which is then taken again.
+    // Values moved out of a detached_list (take_all()) while a snapshot
+    // is running may be read by its walk.
+    list_snapshot snapshot() const {
+        static_assert( is_versioned, "snapshot() needs versioned_nodes" );
+        static_assert( Reclaimer::covers_unlinked_nodes,
+                       "snapshot() walks on through unlinked nodes, which needs a Reclaimer that covers them" );
+        auto &clock = detail::version_clock();
+        auto values = std::vector<T>{};
+        for (;;) {
+            values.clear();
+            // Erasures check for open snapshots before they unlink, so an
+            // unlink that may hide a node from the walk gets counted
+            m_snapshots.m_open.fetch_add(1, std::memory_order_seq_cst);
+            auto late = m_snapshots.m_late_unlinks.load(std::memory_order_seq_cst);
+            auto version = clock.fetch_add(1, std::memory_order_seq_cst);
+            try {
+                auto g = guard_t{};
+                for (auto p = g.protect(m_head); p; ) {
+                    auto w = p->m_link.load();
+                    if (p->alive_at(version, link_t::is_deleted(w))) {
+                        values.push_back(p->m_val);
+                    }
+                    p = link_t::pointer_of(w);
+                }
+            } catch (...) {
+                m_snapshots.m_open.fetch_sub(1, std::memory_order_seq_cst);
+                throw;
+            }
+            m_snapshots.m_open.fetch_sub(1, std::memory_order_seq_cst);
+            if (m_snapshots.m_late_unlinks.load(std::memory_order_seq_cst) == late) {
+                return list_snapshot{ std::move(values), version };
+            }
+        }
+    }
+
     // Modifiers
     // --------------------------------------------------   
 
     // Release all nodes in the list
+    // With teardown::background the detached nodes are only sealed
+    // later, until then operations on iterators into them may still
+    // succeed, without effect on the list.
     void clear() {
-	    // m_head's maintains a chain of nodes
-	    // whose lifetimes are control by shared_ptr
-	    // releasing the head also release all successors
-	    auto tmp = std::atomic_load_explicit(&m_head, std::memory_order_acquire);
-	    auto clr = pointer{};
-        while (!atomic_compare_exchange_weak( &m_head, 
-                                              &tmp,
-                                              clr)) ;
-        // Empty loop body
+        // Detach the whole chain at once
+        note_unlink();
+        auto p = m_head.exchange(nullptr, std::memory_order_acq_rel);
+        if (!p) {
+            return;
+        }
+        if (m_teardown == teardown::background) {
+            auto job = std::make_unique<clear_job>(clear_job{ p, m_size });
+            background_reclaimer::instance().defer(job.get(), &run_clear_job);
+            job.release();
+        } else {
+            m_size->sub(retire_chain(p));
+        }
     }    
+    // Take all elements out of the list at once, the returned
+    // list owns them. Like clear(), operations still holding 
+    // iterators into the taken nodes fail; iterators may still 
+    // read the values.
+    detached_list take_all() {
+        auto taken = detached_list{};
+        note_unlink();
+        auto p = m_head.exchange(nullptr, std::memory_order_acq_rel);
+        while (p) {
+            auto next = pointer{};
+            if (seal(p, next)) {
+                taken.push_back(p);
+                m_size->sub(1);
+            } else {
+                retire_node(p);     // Erased but not unlinked yet, now ours
+            }
+            p = next;
+        }
+        return taken;
+    }
     void push_front(const T &val) {
-        auto new_node 
-		    = std::make_shared<node_type>( val, 
-                                           std::atomic_load_explicit(&m_head,std::memory_order_acquire));        
-        while (!atomic_compare_exchange_weak( &m_head, 
-                                              &new_node->m_next, 
-                                              new_node)) ;
-        // Empty loop body
+        emplace_front(val);
+    }
+    void push_front(T &&val) {
+        emplace_front(std::move(val));
+    }
+    // Construct an element in place at the front.
+    // Pushes publish with a seq_cst CAS, which orders them before the
+    // check for parked consumers (see waiter_list.hpp).
+    template<typename... Args>
+    void emplace_front(Args&&... args) {
+        auto head = m_head.load(std::memory_order_relaxed);
+        auto new_node = create_node(head, std::forward<Args>(args)...);
+        auto b = detail::backoff{};
+        Stats::call(list_op::push_front);
+        while (!tally_cas(list_op::push_front,
+                          m_head.compare_exchange_weak( head, 
+                                                        new_node, 
+                                                        std::memory_order_seq_cst,
+                                                        std::memory_order_relaxed))) {
+            if (m_elimination && m_elimination->offer(new_node)) {
+                m_size->add(1);
+                return;     // Handed to a pop_front()
+            }
+            b.pause();
+            head = m_head.load(std::memory_order_relaxed);
+            new_node->m_link.init(head);
+        }
+        m_size->add(1);
+        m_waiters.notify();
+    }
+    // Push copies of [first, last) to the front, keeping their order.
+    // The nodes are linked privately and published with one CAS,
+    // so other threads see either none or all of them.
+    template<typename InputIt>
+    void push_front_range(InputIt first, InputIt last) {
+        auto chain = make_chain(first, last);
+        if (chain.empty()) {
+            return;
+        }
+        auto head = m_head.load(std::memory_order_relaxed);
+        auto b = detail::backoff{};
+        Stats::call(list_op::push_front);
+        for (;;) {
+            chain.m_last->m_link.init(head);
+            if (tally_cas(list_op::push_front,
+                          m_head.compare_exchange_weak( head,
+                                                        chain.m_first,
+                                                        std::memory_order_seq_cst,
+                                                        std::memory_order_relaxed))) {
+                break;
+            }
+            b.pause();
+            head = m_head.load(std::memory_order_relaxed);
+        }
+        auto count = chain.m_count;
+        m_size->add(count);
+        chain.release();
+        m_waiters.notify(count);
     }
     // Release the first node of the list
     void pop_front() {
-        auto old_head = std::atomic_load_explicit( &m_head, 
-                                                   std::memory_order_acquire);
-        while ( old_head 
-                && !atomic_compare_exchange_weak( &m_head, 
-                                                  &old_head, 
-                                                  old_head->m_next)) ;
-        // Empty loop body        
-
-        // Acquire lock on the popped node, mark as deleted
-        auto lock = std::move(old_head->lock());
-        if (!old_head->mark_as_deleted()) {
-            throw std::runtime_error{ "node is already marked as deleted!" };
+        auto g = guard_t{};
+        unlink_front(g);
+    }
+    // Release the first node of the list and copy its value out.
+    // Iterators, traversals and snapshots that passed the node before
+    // it was unlinked may still be reading the value, so it is left
+    // intact: only trivially copyable values, where a move is a copy,
+    // are moved.
+    // Returns std::nullopt if the list is empty
+    std::optional<T> try_pop_front() {
+        auto g = guard_t{};
+        auto p = unlink_front(g);
+        if (!p) {
+            return std::nullopt;
         }
+        return std::optional<T>{ take_value(p) };
     }
+    // Returns a bool indicates if a value was copied into out
+    bool try_pop_front(T &out) {
+        auto g = guard_t{};
+        auto p = unlink_front(g);
+        if (!p) {
+            return false;
+        }
+        out = take_value(p);
+        return true;
+    }
+    // Pop the first element, or wait up to timeout for one to be
+    // pushed. A consumer finding the list empty parks instead of polling;
+    // every successful push or insertion wakes one parked consumer per
+    // element added, and takes a lock only when someone is parked.
+    // Returns std::nullopt if nothing could be popped in time
+    template<typename Rep, typename Period>
+    std::optional<T> wait_pop_front(const std::chrono::duration<Rep, Period> &timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        auto value = try_pop_front();
+        while (!value) {
+            auto cv = std::condition_variable{};
+            auto w = detail::waiter_list::waiter{};
+            w.m_cv = &cv;
+            auto take = [&] {
+                value = try_pop_front();
+                return value.has_value();
+            };
+            if (m_waiters.enqueue_unless(w, take)) {
+                break;
+            }
+            if (!m_waiters.wait_until(w, deadline)) {
+                return try_pop_front();
+            }
+        }
+        return value;
+    }
+#if HUNGBIU_COROUTINES
+    // co_await async_pop_front() pops the first element, suspending the
+    // coroutine in the same waiter list while the list is empty
+    pop_awaiter async_pop_front() noexcept {
+        return pop_awaiter{ *this };
+    }
+#endif
     // Insert an element after the specified position 
     // Returns a bool indicates if the insertion actually take place
-    bool insert_after(const_iterator pos, const T &val) {
+    bool insert_after(const const_iterator &pos, const T &val) {
+        return emplace_after(pos, val);
+    }
+    bool insert_after(const const_iterator &pos, T &&val) {
+        return emplace_after(pos, std::move(val));
+    }
+    // Construct an element in place after the specified position
+    // Returns a bool indicates if the insertion actually take place
+    template<typename... Args>
+    bool emplace_after(const const_iterator &pos, Args&&... args) {
+        auto p = pos.m_node_ptr;
+        if (!p) {
+            return false;
+        }
+
         // Allocate a new node
-        auto new_node = std::make_shared<node_type>(val);      
+        auto new_node = node_chain{ create_node(nullptr, std::forward<Args>(args)...) };
+        return counted_splice_after(p, new_node);
+    }
+    // Insert copies of [first, last) after the specified position, 
+    // keeping their order, in one step
+    // Returns a bool indicates if the insertion actually take place
+    template<typename InputIt>
+    bool insert_after_range(const const_iterator &pos, InputIt first, InputIt last) {
+        auto p = pos.m_node_ptr;
+        if (!p) {
+            return false;
+        }
+        auto chain = make_chain(first, last);
+        return chain.empty() ? !p->is_deleted() : counted_splice_after(p, chain);
+    }
+    // Erase the element after the specified position
+    // Returns a bool indicates if the erasure actually take place
+    bool erase_after(const const_iterator &pos) {   
+        auto pre = pos.m_node_ptr;
+         
+        // Return false if the pos is not valid or the end of the list
+        if ( !pre ||  
+             !pre->next())
+            return false;
 
+        Stats::call(list_op::erase_after);
+        auto erased = false;
+        if constexpr (is_lock_free) {
+            erased = lock_free_erase_after(pre);
+        } else {
+            erased = locked_erase_after(pre);
+        }
+        if (erased) {
+            m_size->sub(1);
+        }
+        return erased;
+    }
+    // Insert an element after the first element satisfying pred
+    // Returns a bool indicates if the insertion actually take place,
+    // false only if no element satisfies pred
+    template<typename Pred>
+    bool insert_after_if(Pred pred, const T &val) {
+        return emplace_after_if(std::move(pred), val);
+    }
+    template<typename Pred>
+    bool insert_after_if(Pred pred, T &&val) {
+        return emplace_after_if(std::move(pred), std::move(val));
+    }
+    // Construct an element in place after the first element satisfying
+    // pred. The position is searched for and updated in one call: if it is
+    // erased before the insertion lands, the search resumes from the live
+    // node it passed last, not from the head. pred may see an element
+    // more than once.
+    template<typename Pred, typename... Args>
+    bool emplace_after_if(Pred pred, Args&&... args) {
+        auto chain = node_chain{ create_node(nullptr, std::forward<Args>(args)...) };
+        auto s = search_state{};
+        while (auto p = search(pred, s)) {
+            if (counted_splice_after(p, chain)) {
+                return true;
+            }
+            Stats::stale(list_op::insert_after);
+        }
+        return false;
+    }
+    // Erase the first element satisfying pred, resuming the search from
+    // the live node it passed last whenever the element or its predecessor
+    // changes under it. pred may see an element more than once.
+    // Returns a bool indicates if the erasure actually take place
+    template<typename Pred>
+    bool erase_if_first(Pred pred) {
+        auto s = search_state{};
+        while (auto p = search(pred, s)) {
+            Stats::call(list_op::erase_after);
+            auto erased = false;
+            if constexpr (is_lock_free) {
+                erased = lock_free_erase(s.m_prev, p);
+            } else {
+                erased = s.m_prev ? locked_erase_after(s.m_prev, p) : locked_unlink_head(p, list_op::erase_after);
+            }
+            if (erased) {
+                m_size->sub(1);
+                return true;
+            }
+            Stats::stale(list_op::erase_after);
+        }
+        return false;
+    }
+    // The most nodes remove_if() unlinks in one link update
+    static constexpr size_t RunLimit = 64;
+
+    // Erase every element satisfying pred in one pass over the list.
+    // A run of adjacent matching nodes, up to RunLimit long, is unlinked
+    // with one update of the link before it: under locking_policy the
+    // walk locks hand over hand and holds the locks of the run until it
+    // is unlinked; under lock_free_policy the run is marked node by node
+    // and unlinked with one CAS. Elements inserted meanwhile behind the
+    // walk are not looked at; pred may see an element more than once.
+    // Returns the number of elements erased
+    template<typename Pred>
+    size_t remove_if(Pred pred) {
+        auto removed = size_t{ 0 };
+        try {
+            if constexpr (is_lock_free) {
+                lock_free_remove_if(pred, removed);
+            } else {
+                locked_remove_if(pred, removed);
+            }
+        } catch (...) {
+            m_size->sub(removed);
+            throw;
+        }
+        m_size->sub(removed);
+        return removed;
+    }
+
+    // Capacity
+    bool empty() const noexcept {
+        return !m_head.load(std::memory_order_acquire);
+    }
+    // The number of elements, counted by the modifiers as they complete.
+    // approx_size() is one relaxed pass over the counter stripes and may
+    // be off while modifiers race with it. size() retries until it reads
+    // a consistent snapshot of the counts, exact whenever no modifier is
+    // halfway through.
+    size_t approx_size() const noexcept {
+        return m_size->approx();
+    }
+    size_t size() const noexcept {
+        return m_size->exact();
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return allocator_type{};
+    }
+
+private:
+    template<typename... Args>
+    static pointer create_node(Args&&... args) {
+        auto alloc = node_allocator{};
+        auto p = node_alloc_traits::allocate(alloc, 1);
+        try {
+            node_alloc_traits::construct(alloc, p, std::forward<Args>(args)...);
+        } catch (...) {
+            node_alloc_traits::deallocate(alloc, p, 1);
+            throw;
+        }
+        if constexpr (is_versioned) {
+            p->stamp_birth();
+        }
+        return p;
+    }
+    static void destroy_node(void *p) {
+        auto alloc = node_allocator{};
+        auto node = static_cast<pointer>(p);
+        node_alloc_traits::destroy(alloc, node);
+        node_alloc_traits::deallocate(alloc, node, 1);
+    }
+    static void retire_node(pointer p) {
+        Reclaimer::retire(p, &destroy_node);
+    }
+    // Read before every attempt to mark a node deleted, see version_stamps.hpp
+    static uint64_t death_clock() noexcept {
+        if constexpr (is_versioned) {
+            return list_node::death_clock();
+        } else {
+            return 0;
+        }
+    }
+    // Called by whoever marked p deleted, with its reading from before
+    static void stamp_death(pointer p, uint64_t death) noexcept {
+        if constexpr (is_versioned) {
+            p->stamp_death(death);
+        }
+    }
+    // Called before every unlink, see snapshot()
+    void note_unlink() const noexcept {
+        if constexpr (is_versioned) {
+            if (m_snapshots.m_open.load(std::memory_order_seq_cst)) {
+                m_snapshots.m_late_unlinks.fetch_add(1, std::memory_order_seq_cst);
+            }
+        }
+    }
+    // The value of a popped node. A reader that checked the node's mark
+    // before the pop may still read the value, so it is not modified.
+    static decltype(auto) take_value(pointer p) {
+        static_assert( std::is_trivially_copyable_v<T> || std::is_copy_constructible_v<T>,
+                       "popping copies the value out, readers may still be at the node" );
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            return std::move(p->m_val);
+        } else {
+            return std::as_const(p->m_val);
+        }
+    }
+    // Take the nodes of a detached chain out one by one, so that 
+    // operations still holding iterators into the chain fail
+    // instead of racing. Returns the number of nodes sealed, those
+    // not erased by someone else first.
+    static size_t retire_chain(pointer p) {
+        auto sealed = size_t{ 0 };
+        while (p) {
+            auto next = pointer{};
+            sealed += seal(p, next);    // Frozen now that p is deleted
+            retire_node(p);
+            p = next;
+        }
+        return sealed;
+    }
+    // A chain cleared on the background_reclaimer thread, which counts
+    // the nodes it takes out, possibly after the list is gone
+    struct clear_job
+    {
+        pointer     m_first;
+        counter_ptr m_size;
+    };
+    static void run_clear_job(void *p) {
+        auto job = std::unique_ptr<clear_job>{ static_cast<clear_job *>(p) };
+        job->m_size->sub(retire_chain(job->m_first));
+    }
+    // Free a chain no other thread can reach
+    static void destroy_chain(void *first) {
+        auto p = static_cast<pointer>(first);
+        while (p) {
+            auto next = p->next();
+            destroy_node(p);
+            p = next;
+        }
+    }
+    template<typename InputIt>
+    static node_chain make_chain(InputIt first, InputIt last) {
+        auto chain = node_chain{};
+        for (; first != last; ++first) {
+            chain.push_back(create_node(nullptr, *first));
+        }
+        return chain;
+    }
+    // Walk the live nodes like for_each(), prefetching the successor of
+    // each node before visiting it
+    template<typename Visit>
+    void visit_prefetching(guard_t &g, Visit visit) const {
+        traversal::visit_live(typename traversal::head_anchor{ m_head }, g, [&visit](pointer p) {
+            if (auto n = link_t::pointer_of(p->m_link.load(std::memory_order_relaxed))) {
+                detail::prefetch(n);
+                if constexpr (is_split_layout) {
+                    detail::prefetch(&n->m_val);
+                }
+            }
+            visit(p);
+            return true;
+        });
+    }
+    // Guards of a positional search: the last live node passed (null
+    // while at the head) and the candidate, plus scratch for traversal
+    struct search_state
+    {
+        pointer m_prev = nullptr;
+        guard_t m_prev_guard;
+        guard_t m_cur_guard;
+        guard_t m_next_guard;
+        guard_t m_skip_guard;
+    };
+    // Protect the first live node behind s.m_prev (or the head) that
+    // satisfies pred with s.m_cur_guard, moving s.m_prev along. Called
+    // again after a failed update, it starts over from s.m_prev, or from
+    // the head if s.m_prev got erased meanwhile.
+    template<typename Pred>
+    pointer search(Pred &pred, search_state &s) const {
+        if (s.m_prev && s.m_prev->is_deleted()) {
+            s.m_prev = nullptr;
+        }
+        for (;;) {
+            auto p = s.m_prev
+                   ? traversal::first_live(typename traversal::link_anchor{ s.m_prev->m_link },
+                                           s.m_cur_guard, s.m_next_guard, s.m_skip_guard)
+                   : traversal::first_live(typename traversal::head_anchor{ m_head },
+                                           s.m_cur_guard, s.m_next_guard, s.m_skip_guard);
+            if (!p) {
+                // Without covering unlinked nodes, a traversal out of an
+                // erased node stops early
+                if (!s.m_prev || !s.m_prev->is_deleted()) {
+                    return nullptr;
+                }
+                s.m_prev = nullptr;
+                continue;
+            }
+            if (pred(std::as_const(p->m_val))) {
+                return p;
+            }
+            s.m_prev = p;
+            s.m_prev_guard.swap(s.m_cur_guard);
+        }
+    }
+    static bool splice_after(pointer p, node_chain &chain) {
+        if constexpr (is_lock_free) {
+            return lock_free_insert_after(p, chain);
+        } else {
+            return locked_insert_after(p, chain);
+        }
+    }
+    bool counted_splice_after(pointer p, node_chain &chain) {
+        Stats::call(list_op::insert_after);
+        auto count = chain.m_count;
+        if (!splice_after(p, chain)) {
+            return false;
+        }
+        m_size->add(count);
+        // A consumer may pop the position's element before the inserted
+        // ones are taken, so insertions wake parked consumers as well
+        m_waiters.notify(count);
+        return true;
+    }
+    // Take the first node out of the list. Returns the node, erased and
+    // left to reclamation but still protected by g, or nullptr if the 
+    // list is empty.
+    // Readers that passed the node before it was unlinked may still read
+    // its value, so the caller may only read it too.
+    pointer unlink_front(guard_t &g) {
+        Stats::call(list_op::pop_front);
+        auto p = pointer{};
+        if constexpr (is_lock_free) {
+            p = lock_free_pop_front(g);
+        } else {
+            p = locked_pop_front(g);
+        }
+        if (p) {
+            m_size->sub(1);
+        }
+        return p;
+    }
+    // After a lost race on the head: take a node a push_front() offers
+    // instead, or back off. The node taken was never published, it is
+    // retired right away and protected by g like a popped one.
+    pointer eliminate_or_pause(guard_t &g, detail::backoff &b) {
+        if (m_elimination) {
+            if (auto p = m_elimination->take()) {
+                g.set(p);
+                retire_node(p);
+                return p;
+            }
+        }
+        b.pause();
+        return nullptr;
+    }
+
+    // Report a CAS of op to Stats and pass its result on
+    static bool tally_cas(list_op op, bool succeeded) noexcept {
+        Stats::cas(op, succeeded);
+        return succeeded;
+    }
+    // Lock p for op. If Stats counts, a lock that is not free
+    // right away is waited for with the wait timed.
+    static typename list_node::unique_lock_t lock_node(pointer p, list_op op) noexcept {
+        if constexpr (Stats::enabled) {
+            if (!p->m_link.try_lock()) {
+                auto start = std::chrono::steady_clock::now();
+                p->m_link.lock();
+                auto waited = std::chrono::steady_clock::now() - start;
+                Stats::lock_wait(op, std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+            }
+            return typename list_node::unique_lock_t{ p->m_link, std::adopt_lock };
+        } else {
+            return p->lock();
+        }
+    }
+
+    // locking_policy
+    // --------------------------------------------------   
+
+    pointer locked_pop_front(guard_t &g) {
+        auto b = detail::backoff{};
+        for (;;) {
+            auto old_head = g.protect(m_head);
+            if (!old_head) {
+                return nullptr;
+            }
+            if (locked_unlink_head(old_head, list_op::pop_front)) {
+                return old_head;
+            }
+            if (auto p = eliminate_or_pause(g, b)) {
+                return p;
+            }
+        }
+    }
+    // Erase the protected node p if it is still the head
+    // Returns false if it was erased by someone else or pushes moved the head
+    bool locked_unlink_head(pointer p, list_op op) {
+        // Acquire lock on the head, then on its successor, so
+        // neither can be unlinked by someone else meanwhile
+        auto lock = lock_node(p, op);
+        if (p->is_deleted()) {
+            Stats::stale(op);
+            return false;   // Popped or cleared under us
+        }
+        auto next = p->next();
+        auto next_lock = next ? lock_node(next, op) : typename list_node::unique_lock_t{};
+
+        auto death = death_clock();
+        note_unlink();
+        auto expected = p;
+        if (!tally_cas(op, m_head.compare_exchange_strong(expected, next))) {
+            return false;
+        }
+        if (!p->mark_as_deleted()) {
+            throw std::runtime_error{ "node is already marked as deleted!" };
+        }
+        stamp_death(p, death);
+        next_lock = {};
+        lock.unlock();
+        retire_node(p);
+        return true;
+    }
+    static bool locked_insert_after(pointer p, node_chain &chain) {
         // Acquire lock on position
-        auto &p = pos.m_node_ptr; // Does NOT bump the ref count    
-        auto lock = std::move(p->lock());
+        auto lock = lock_node(p, list_op::insert_after);
 
         // Check if the position is still valid
         if (p->is_deleted()) {
+            Stats::stale(list_op::insert_after);
             return false;
         }
 
         // Perform actual insertion
-        new_node->m_next = p->m_next;
-        p->m_next = new_node;      
+        chain.m_last->m_link.init(p->next());
+        p->m_link.set_next(chain.m_first);
+        chain.release();
 
         return true;     
     }
-    // Erase the element after the specified position
-    // Returns a bool indicates if the erasure actually take place
-    bool erase_after(const_iterator pos) {   
-        auto &pre = pos.m_node_ptr; // Does NOT bump the ref count
-         
-        // Return false if the pos is not valid or the end of the list
-        if ( !pre ||  
-             !std::atomic_load_explicit( &(pre->m_next), 
-                                         std::memory_order_acquire))
-            return false;
-
+    // Erase the successor of pre, only if it is expected when given
+    bool locked_erase_after(pointer pre, pointer expected = nullptr) {
         // Acquire lock on position (the predecessor)        
-        auto pre_lock  = std::move(pre->lock());
+        auto pre_lock  = lock_node(pre, list_op::erase_after);
 
         // Check if both positions are still valid
-        if ( pre->is_deleted() || !pre->m_next) {
+        auto del = pre->next();
+        if (pre->is_deleted()) {
+            Stats::stale(list_op::erase_after);
+            return false;
+        }
+        if (!del || (expected && del != expected)) {
             return false;
         }        
 
-        // Acquire lock on the node to be deleted and perform actual erasure
-        auto del = pre->m_next; // Extend delete node's lifetime, 
-                                // otherwise it could vanish once modify pre->m_next
+        // Acquire lock on the node to be deleted and perform actual erasure.
+        // Mark before unlinking, so that a reader seeing del
+        // still linked also sees it is not deleted yet.
         {                        
-            auto del_lock = std::move(del->lock());
-            pre->m_next = del->m_next;
+            auto del_lock = lock_node(del, list_op::erase_after);
+            auto death = death_clock();
             if (!del->mark_as_deleted()) {
                 throw std::runtime_error{ "node is already marked as deleted!" };
             }
+            stamp_death(del, death);
+            note_unlink();
+            pre->m_link.set_next(del->next());
         }        
+        pre_lock.unlock();
+        retire_node(del);
         return true;     
     }
 
-    // Capacity
-    bool empty() const noexcept {
-        return !std::atomic_load_explicit(&m_head, std::memory_order_acquire);
+    // Adjacent nodes remove_if() holds the locks of, released on exit
+    struct locked_run
+    {
+        pointer m_nodes[RunLimit];
+        size_t  m_count = 0;
+
+        locked_run() = default;
+        locked_run(const locked_run &) = delete;
+        locked_run &operator= (const locked_run &) = delete;
+        ~locked_run() {
+            unlock();
+        }
+
+        bool full() const noexcept {
+            return m_count == RunLimit;
+        }
+        pointer back() const noexcept {
+            return m_nodes[m_count - 1];
+        }
+        // Take over the lock held on p
+        void push_back(typename list_node::unique_lock_t &lock, pointer p) noexcept {
+            lock.release();
+            m_nodes[m_count++] = p;
+        }
+        void unlock() noexcept {
+            for (size_t i = 0; i < m_count; ++i) {
+                m_nodes[i]->m_link.unlock();
+            }
+            m_count = 0;
+        }
+        // Mark the nodes before they are unlinked, then hand
+        // them to reclamation once they are
+        void mark() {
+            auto death = death_clock();
+            for (size_t i = 0; i < m_count; ++i) {
+                if (!m_nodes[i]->mark_as_deleted()) {
+                    throw std::runtime_error{ "node is already marked as deleted!" };
+                }
+                stamp_death(m_nodes[i], death);
+            }
+        }
+        void retire() noexcept {
+            auto count = m_count;
+            unlock();
+            for (size_t i = 0; i < count; ++i) {
+                retire_node(m_nodes[i]);
+            }
+        }
+    };
+    // Lock the successors of the run's last node for as long as they
+    // satisfy pred. Returns the node the run ends before, unlocked.
+    template<typename Pred>
+    static pointer extend_run(locked_run &run, Pred &pred) {
+        for (;;) {
+            auto s = run.back()->next();
+            if (!s || run.full()) {
+                return s;
+            }
+            auto lock = lock_node(s, list_op::erase_after);
+            if (!pred(std::as_const(s->m_val))) {
+                return s;
+            }
+            run.push_back(lock, s);
+        }
+    }
+    // A locked node cannot be erased, nor can its successor be unlinked,
+    // so locks are handed over along the list without guards. Only the
+    // head is protected before it is locked.
+    template<typename Pred>
+    void locked_remove_if(Pred &pred, size_t &removed) {
+        auto pre_lock = typename list_node::unique_lock_t{};
+        auto pre = pointer{};
+        auto run = locked_run{};
+
+        // A run at the head is unlinked by CAS on the head, and
+        // retried from the new head if pushes moved it
+        auto g = guard_t{};
+        for (;;) {
+            auto h = g.protect(m_head);
+            if (!h) {
+                return;
+            }
+            auto lock = lock_node(h, list_op::erase_after);
+            if (h->is_deleted()) {
+                continue;
+            }
+            if (!pred(std::as_const(h->m_val))) {
+                pre = h;
+                pre_lock = std::move(lock);
+                break;
+            }
+            run.push_back(lock, h);
+            auto s = extend_run(run, pred);
+            note_unlink();
+            auto expected = h;
+            if (tally_cas(list_op::erase_after, m_head.compare_exchange_strong(expected, s))) {
+                run.mark();
+                removed += run.m_count;
+                run.retire();
+            } else {
+                run.unlock();
+            }
+        }
+        g.reset();
+
+        // Then behind the locked pre
+        for (;;) {
+            auto del = pre->next();
+            if (!del) {
+                return;
+            }
+            auto lock = lock_node(del, list_op::erase_after);
+            if (!pred(std::as_const(del->m_val))) {
+                pre = del;
+                pre_lock = std::move(lock);
+                continue;
+            }
+            run.push_back(lock, del);
+            auto s = extend_run(run, pred);
+            run.mark();
+            note_unlink();
+            pre->m_link.set_next(s);
+            removed += run.m_count;
+            run.retire();
+        }
+    }
+
+    // lock_free_policy
+    // --------------------------------------------------   
+    // A node is erased once its link is marked. Whoever then unlinks
+    // it by CAS on the predecessor (m_head or a node link) retires it;
+    // a mark can only be set on an unmarked link, and an unmarked link
+    // can only be swung from an unmarked predecessor.
+
+    pointer lock_free_pop_front(guard_t &g) {
+        auto b = detail::backoff{};
+        for (;;) {
+            auto old_head = g.protect(m_head);
+            if (!old_head) {
+                return nullptr;
+            }
+            auto death = death_clock();
+            auto w = old_head->m_link.load();
+            if ( !link_t::is_deleted(w) && 
+                 !tally_cas(list_op::pop_front, old_head->m_link.try_mark(w))) {
+                if (auto p = eliminate_or_pause(g, b)) {
+                    return p;
+                }
+                continue;   // The successor changed, or someone else marked it
+            }
+            if (!link_t::is_deleted(w)) {
+                stamp_death(old_head, death);
+            }
+            // Unlink it, or help the thread that marked the head first
+            note_unlink();
+            auto expected = old_head;
+            auto unlinked = tally_cas(list_op::pop_front, m_head.compare_exchange_strong(expected, link_t::pointer_of(w)));
+            if (unlinked) {
+                retire_node(old_head);
+            }
+            // A failed unlink of our own mark means pushes moved the head,
+            // the marked node is then unlinked by a later erase_after()
+            if (!link_t::is_deleted(w)) {
+                return old_head;
+            }
+            Stats::stale(list_op::pop_front);
+            if (auto p = eliminate_or_pause(g, b)) {
+                return p;
+            }
+        }
+    }
+    static bool lock_free_insert_after(pointer p, node_chain &chain) {
+        auto w = p->m_link.load();
+        do {
+            // Check if the position is still valid
+            if (link_t::is_deleted(w)) {
+                Stats::stale(list_op::insert_after);
+                return false;
+            }
+            chain.m_last->m_link.init(link_t::pointer_of(w));
+        } while (!tally_cas(list_op::insert_after, p->m_link.compare_exchange(w, chain.m_first))) ;
+        chain.release();
+        return true;
+    }
+    bool lock_free_erase_after(pointer pre) {
+        auto g = guard_t{};
+        for (;;) {
+            auto w = pre->m_link.load();
+            auto del = link_t::pointer_of(w);
+            if (link_t::is_deleted(w)) {
+                Stats::stale(list_op::erase_after);
+                return false;
+            }
+            if (!del) {
+                return false;
+            }
+            g.set(del);
+            if (pre->m_link.load(std::memory_order_seq_cst) != w) {
+                continue;
+            }
+
+            auto dw = del->m_link.load();
+            if (link_t::is_deleted(dw)) {
+                // Someone else erased it, help to unlink it and retry
+                note_unlink();
+                if (tally_cas(list_op::erase_after, pre->m_link.compare_exchange(w, link_t::pointer_of(dw)))) {
+                    retire_node(del);
+                }
+                continue;
+            }
+            auto death = death_clock();
+            if (!tally_cas(list_op::erase_after, del->m_link.try_mark(dw))) {
+                continue;
+            }
+            stamp_death(del, death);
+            // Erased. If unlinking fails, pre gained a new successor or
+            // got erased itself; del is then unlinked by a later helper.
+            note_unlink();
+            if (tally_cas(list_op::erase_after, pre->m_link.compare_exchange(w, link_t::pointer_of(dw)))) {
+                retire_node(del);
+            }
+            return true;
+        }
+    }
+
+    // Erase the protected node p behind pre (the head if null) by marking
+    // it, then try once to unlink it. Returns false if p was marked first
+    // by someone else.
+    bool lock_free_erase(pointer pre, pointer p) {
+        auto w = p->m_link.load();
+        auto death = uint64_t{};
+        do {
+            if (link_t::is_deleted(w)) {
+                return false;
+            }
+            death = death_clock();
+        } while (!tally_cas(list_op::erase_after, p->m_link.try_mark(w))) ;
+        stamp_death(p, death);
+
+        // Unlinking fails if pre gained a new successor or got erased,
+        // p is then unlinked by a later helper
+        note_unlink();
+        auto unlinked = false;
+        if (pre) {
+            auto pw = link_t::to_word(p);
+            unlinked = pre->m_link.compare_exchange(pw, link_t::pointer_of(w));
+        } else {
+            auto expected = p;
+            unlinked = m_head.compare_exchange_strong(expected, link_t::pointer_of(w));
+        }
+        if (tally_cas(list_op::erase_after, unlinked)) {
+            retire_node(p);
+        }
+        return true;
+    }
+
+    // Walk behind pre (the head while null), marking the nodes pred
+    // accepts. The run of marked nodes up to the next live node pred
+    // rejects is unlinked with one CAS on the link pw read from pre; if
+    // that fails, the run is left to helpers and the walk re-reads pre.
+    // If the Reclaimer does not cover unlinked nodes, each step also
+    // checks that pre still links to the run, which keeps it reachable.
+    template<typename Pred>
+    void lock_free_remove_if(Pred &pred, size_t &removed) {
+        auto g_pre = guard_t{};
+        auto g_cur = guard_t{};
+        auto g_next = guard_t{};
+        auto pre = pointer{};
+        auto load_anchor = [&](std::memory_order order) {
+            return pre ? pre->m_link.load(order) : link_t::to_word(m_head.load(order));
+        };
+        for (;;) {
+            auto pw = load_anchor(std::memory_order_acquire);
+            if (link_t::is_deleted(pw)) {
+                pre = nullptr;      // pre got erased, start over
+                continue;
+            }
+            auto first = link_t::pointer_of(pw);
+            if (!first) {
+                return;
+            }
+            g_cur.set(first);
+            if (load_anchor(std::memory_order_seq_cst) != pw) {
+                continue;
+            }
+
+            auto c = first;
+            auto len = size_t{ 0 };
+            auto broken = false;
+            for (;;) {
+                auto cw = c->m_link.load();
+                if (!link_t::is_deleted(cw)) {
+                    if (!pred(std::as_const(c->m_val))) {
+                        break;
+                    }
+                    // Nodes erased by someone else meanwhile join the run
+                    while (!link_t::is_deleted(cw)) {
+                        auto death = death_clock();
+                        if (tally_cas(list_op::erase_after, c->m_link.try_mark(cw))) {
+                            stamp_death(c, death);
+                            ++removed;
+                            break;
+                        }
+                    }
+                }
+                auto next = link_t::pointer_of(cw);
+                if (!next || ++len == RunLimit) {
+                    c = next;
+                    break;
+                }
+                if constexpr (!Reclaimer::covers_unlinked_nodes) {
+                    g_next.set(next);
+                    if (load_anchor(std::memory_order_seq_cst) != pw) {
+                        broken = true;
+                        break;
+                    }
+                    g_cur.swap(g_next);
+                }
+                c = next;
+            }
+            if (broken) {
+                continue;
+            }
+            if (c == first) {
+                pre = first;        // Live and kept, step over it
+                g_pre.swap(g_cur);
+                continue;
+            }
+
+            // Whoever unlinks the run retires it, its links are frozen
+            note_unlink();
+            auto unlinked = false;
+            if (pre) {
+                unlinked = pre->m_link.compare_exchange(pw, c);
+            } else {
+                auto expected = first;
+                unlinked = m_head.compare_exchange_strong(expected, c);
+            }
+            if (tally_cas(list_op::erase_after, unlinked)) {
+                for (auto p = first; p != c; ) {
+                    auto next = p->next();
+                    retire_node(p);
+                    p = next;
+                }
+            }
+        }
+    }
+
+    // Traversal
+    // --------------------------------------------------   
+
+    // Mark p, which must not be reachable from m_head any more, as deleted
+    // and let next receive its successor. No one else unlinks p's successor
+    // then. Returns false if p was already erased by someone else.
+    static bool seal(pointer p, pointer &next) {
+        if constexpr (is_lock_free) {
+            auto w = p->m_link.load();
+            for (;;) {
+                if (link_t::is_deleted(w)) {
+                    next = link_t::pointer_of(w);
+                    return false;
+                }
+                auto death = death_clock();
+                if (p->m_link.try_mark(w)) {
+                    stamp_death(p, death);
+                    next = link_t::pointer_of(w);
+                    return true;
+                }
+            }
+        } else {
+            auto lock = p->lock();
+            auto death = death_clock();
+            auto live = p->mark_as_deleted();
+            if (live) {
+                stamp_death(p, death);
+            }
+            next = p->next();
+            return live;
+        }
+    }
+    // Change the successor of a node sealed by the caller
+    static void relink_sealed(pointer p, pointer next) noexcept {
+        if constexpr (is_lock_free) {
+            p->m_link.set_next(next);   // Marked links are never CASed
+        } else {
+            auto lock = p->lock();
+            p->m_link.set_next(next);
+        }
+    }
+    // Protect the first node of the list not marked deleted with g
+    pointer first_live(guard_t &g) const {
+        return traversal::first_live(typename traversal::head_anchor{ m_head }, g);
+    }
+    // Step from the protected node cur to its successor
+    static pointer advance(pointer cur, guard_t &g) {
+        return traversal::advance(cur, g);
     }
 };
 
@@ -0,0 +1,225 @@
+#include "concurrent_forward_list.hpp"
+#include "node_pool.hpp"
+#include "benchmark.hpp"
+#include <forward_list>
+#include <memory>
+#include <mutex>
+
+using namespace hungbiu;
+
+// Every subject offers the same operations, positions are given as
+// a number of steps from the head
+constexpr auto PrefillCount = 1000;
+constexpr auto MaxDepth = 16;
+constexpr auto BatchSize = 16;
+
+template<typename List, contention Contention = contention::backoff>
+class cflist_subject
+{
+private:
+    List m_list{ Contention };
+
+    typename List::const_iterator at(unsigned k) const {
+        auto it = m_list.cbegin();
+        for (; k && it != m_list.cend(); --k) {
+            ++it;
+        }
+        return it;
+    }
+public:
+    void push(int v) {
+        m_list.push_front(v);
+    }
+    void push_batch(const int *first, const int *last) {
+        m_list.push_front_range(first, last);
+    }
+    void pop() {
+        m_list.pop_front();
+    }
+    void insert_at(unsigned k, int v) {
+        auto it = at(k);
+        if (it == m_list.cend() || !m_list.insert_after(it, v)) {
+            m_list.push_front(v);
+        }
+    }
+    void erase_at(unsigned k) {
+        auto it = at(k);
+        if (it != m_list.cend()) {
+            m_list.erase_after(it);
+        }
+    }
+    long scan() const {
+        auto sum = 0l;
+        for (auto it = m_list.cbegin(); it != m_list.cend(); ++it) {
+            sum += *it;
+        }
+        return sum;
+    }
+    long visit() const {
+        auto sum = 0l;
+        m_list.for_each([&sum](int v) { sum += v; });
+        return sum;
+    }
+    long visit_batch() const {
+        auto sum = 0l;
+        m_list.for_each_batch([&sum](const int *values, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                sum += values[i];
+            }
+        });
+        return sum;
+    }
+};
+
+// Baseline: std::forward_list behind one std::mutex
+class locked_forward_list_subject
+{
+private:
+    mutable std::mutex     m_mtx;
+    std::forward_list<int> m_list;
+
+    std::forward_list<int>::iterator at(unsigned k) {
+        auto it = m_list.begin();
+        for (; k && std::next(it) != m_list.end(); --k) {
+            ++it;
+        }
+        return it;
+    }
+public:
+    void push(int v) {
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        m_list.push_front(v);
+    }
+    void push_batch(const int *first, const int *last) {
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        m_list.insert_after(m_list.before_begin(), first, last);
+    }
+    void pop() {
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        if (!m_list.empty()) {
+            m_list.pop_front();
+        }
+    }
+    void insert_at(unsigned k, int v) {
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        if (m_list.empty()) {
+            m_list.push_front(v);
+        } else {
+            m_list.insert_after(at(k), v);
+        }
+    }
+    void erase_at(unsigned k) {
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        if (!m_list.empty()) {
+            auto it = at(k);
+            if (std::next(it) != m_list.end()) {
+                m_list.erase_after(it);
+            }
+        }
+    }
+    long scan() const {
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        auto sum = 0l;
+        for (auto v : m_list) {
+            sum += v;
+        }
+        return sum;
+    }
+    long visit() const {
+        return scan();
+    }
+    long visit_batch() const {
+        return scan();
+    }
+};
+
+template<typename Subject>
+std::vector<bench::mix<Subject>> mixes()
+{
+    typedef bench::operation<Subject> op;
+    auto push = op{ "push_front", 1, [](Subject &s, std::mt19937_64 &rng, unsigned) {
+        s.push(static_cast<int>(rng() & 0xffff));
+    } };
+    auto pop = op{ "pop_front", 1, [](Subject &s, std::mt19937_64 &, unsigned) {
+        s.pop();
+    } };
+    auto push_batch = op{ "push_range", 1, [](Subject &s, std::mt19937_64 &rng, unsigned) {
+        int batch[BatchSize];
+        for (auto &v : batch) {
+            v = static_cast<int>(rng() & 0xffff);
+        }
+        s.push_batch(batch, batch + BatchSize);
+    } };
+    auto pop_batch = pop;
+    pop_batch.m_weight = BatchSize;
+    auto insert = op{ "insert_after", 1, [](Subject &s, std::mt19937_64 &rng, unsigned) {
+        s.insert_at(rng() % MaxDepth, static_cast<int>(rng() & 0xffff));
+    } };
+    auto erase = op{ "erase_after", 1, [](Subject &s, std::mt19937_64 &rng, unsigned) {
+        s.erase_at(rng() % MaxDepth);
+    } };
+    auto scan = op{ "traverse", 18, [](Subject &s, std::mt19937_64 &, unsigned) {
+        bench::do_not_optimize(s.scan());
+    } };
+    auto visit = op{ "for_each", 18, [](Subject &s, std::mt19937_64 &, unsigned) {
+        bench::do_not_optimize(s.visit());
+    } };
+    auto visit_batch = op{ "for_each_batch", 18, [](Subject &s, std::mt19937_64 &, unsigned) {
+        bench::do_not_optimize(s.visit_batch());
+    } };
+    return {
+        { "push_pop",       { push, pop } },
+        { "batch_push_pop", { push_batch, pop_batch } },
+        { "insert_erase",   { insert, erase } },
+        { "read_mostly",    { scan, insert, erase } },
+        { "read_mostly_for_each", { visit, insert, erase } },
+        { "read_mostly_for_each_batch", { visit_batch, insert, erase } },
+    };
+}
+
+template<typename Subject>
+void run_subject(const char *name, const bench::options &opts)
+{
+    if (!opts.wants_subject(name)) {
+        return;
+    }
+    for (auto &m : mixes<Subject>()) {
+        if (!opts.wants_mix(m.m_name)) {
+            continue;
+        }
+        for (auto threads : opts.thread_counts()) {
+            auto subject = std::make_unique<Subject>();
+            for (auto i = 0; i < PrefillCount; ++i) {
+                subject->push(i);
+            }
+            auto r = bench::run(*subject, m, threads, opts.m_duration);
+            bench::print_result(name, m.m_name, threads, r);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    auto opts = bench::options{ argc, argv };
+    bench::print_header();
+    run_subject<locked_forward_list_subject>("mutex+std::forward_list", opts);
+    run_subject<cflist_subject<concurrent_forward_list<int, epoch_reclaimer>>>(
+        "cflist<locking,epoch>", opts);
+    run_subject<cflist_subject<concurrent_forward_list<int, hazard_pointer_reclaimer>>>(
+        "cflist<locking,hazard>", opts);
+    run_subject<cflist_subject<concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, lock_free_policy>>>(
+        "cflist<lock_free,epoch>", opts);
+    run_subject<cflist_subject<concurrent_forward_list<int, hazard_pointer_reclaimer, std::allocator<int>, lock_free_policy>>>(
+        "cflist<lock_free,hazard>", opts);
+    run_subject<cflist_subject<concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, lock_free_policy>,
+                               contention::elimination>>(
+        "cflist<lock_free,epoch,elimination>", opts);
+    run_subject<cflist_subject<concurrent_forward_list<int, epoch_reclaimer, node_pool_allocator<int>>>>(
+        "cflist<locking,epoch,pool>", opts);
+    run_subject<cflist_subject<concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, locking_policy,
+                                                       no_stats, split_layout>>>(
+        "cflist<locking,epoch,split>", opts);
+    run_subject<cflist_subject<concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, lock_free_policy,
+                                                       no_stats, split_layout>>>(
+        "cflist<lock_free,epoch,split>", opts);
+}
@@ -0,0 +1,281 @@
+#include "concurrent_forward_list.hpp"
+#include "stress.hpp"
+#include <stdio.h>
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include <iterator>
+#include <optional>
+#include <thread>
+
+using namespace hungbiu;
+
+// Usage: concurrent_forward_list_stress_test [--threads N] [--duration MS]
+//                                            [--mix stack|list|snapshot] [--seed S]
+// Every list configuration runs every mix with 1, 2, 4, ... up to N threads,
+// the snapshot mix on versioned lists only
+
+constexpr auto PrefillCount = 8;
+constexpr auto Empty = -1;   // Result of a pop from an empty list
+
+enum stress_op : unsigned { push, pop, insert, erase, contains, remove_key, erase_next, take_snapshot };
+
+// Which operations a mix draws from
+enum class stress_mix { stack, list, snapshot };
+
+// The hash a snapshot's result is recorded as
+template<typename It>
+int contents_hash(It first, It last)
+{
+    auto h = uint32_t{ 2166136261u };
+    for (; first != last; ++first) {
+        h = (h ^ static_cast<uint32_t>(*first)) * 16777619u;
+    }
+    return static_cast<int>(h & 0x7fffffff);
+}
+
+// The list as a sequence, front first. Values are unique.
+// remove_if() takes a predicate matching one key: over several keys it is
+// not atomic, erasures of the others at either side of its walk may
+// interleave with its own, so it would not match any sequential model.
+template<typename List, stress_mix Mix>
+struct list_model
+{
+    typedef std::vector<int> state_type;
+
+    static state_type observe(const List &lst) {
+        auto s = state_type{};
+        lst.for_each([&s](int v) { s.push_back(v); });
+        return s;
+    }
+    static void pick(std::mt19937_64 &rng, const state_type &s, int fresh, stress::event &e) {
+        e.m_arg = fresh;
+        if (Mix == stress_mix::stack) {
+            e.m_op = rng() % 2 ? push : pop;
+            return;
+        }
+        static constexpr stress_op ops[] = { push, push, push, pop, pop, insert, insert,
+                                             erase, contains, remove_key, erase_next, take_snapshot };
+        e.m_op = ops[rng() % (std::size(ops) - (Mix == stress_mix::snapshot ? 0 : 1))];
+        // Mostly a value present when the round began, else an absent one
+        e.m_arg2 = !s.empty() && rng() % 4 ? s[rng() % s.size()] : fresh;
+    }
+    static void perform(List &lst, stress::event &e) {
+        auto key = e.m_arg2;
+        switch (e.m_op) {
+        case push:
+            lst.push_front(e.m_arg);
+            break;
+        case pop:
+            e.m_result = lst.try_pop_front().value_or(Empty);
+            break;
+        case insert:
+            e.m_result = lst.insert_after_if([key](int v) { return v == key; }, e.m_arg);
+            break;
+        case erase:
+            e.m_result = lst.erase_if_first([key](int v) { return v == key; });
+            break;
+        case contains:
+            e.m_result = lst.find_if([key](int v) { return v == key; }) != lst.end();
+            break;
+        case remove_key:
+            e.m_result = static_cast<int>(lst.remove_if([key](int v) { return v == key; }));
+            break;
+        case erase_next: {
+            // Found and erased behind in two steps, yet one operation:
+            // erase_after() fails once the key itself is erased
+            auto it = lst.find_if([key](int v) { return v == key; });
+            e.m_result = it != lst.end() && lst.erase_after(it);
+            break;
+        }
+        case take_snapshot:
+            if constexpr (Mix == stress_mix::snapshot) {
+                auto snap = lst.snapshot();
+                e.m_result = contents_hash(snap.begin(), snap.end());
+            }
+            break;
+        }
+    }
+    static bool apply(state_type &s, const stress::event &e) {
+        auto at = std::find(s.begin(), s.end(), e.m_arg2);
+        switch (e.m_op) {
+        case push:
+            s.insert(s.begin(), e.m_arg);
+            return true;
+        case pop:
+            if (s.empty()) {
+                return e.m_result == Empty;
+            }
+            if (s.front() != e.m_result) {
+                return false;
+            }
+            s.erase(s.begin());
+            return true;
+        case insert:
+            if (at == s.end()) {
+                return !e.m_result;
+            }
+            s.insert(at + 1, e.m_arg);
+            return e.m_result;
+        case erase:
+            if (at == s.end()) {
+                return !e.m_result;
+            }
+            s.erase(at);
+            return e.m_result;
+        case contains:
+            return e.m_result == (at != s.end());
+        case remove_key:
+            if (at == s.end()) {
+                return e.m_result == 0;
+            }
+            s.erase(at);
+            return e.m_result == 1;
+        case erase_next:
+            if (at == s.end() || at + 1 == s.end()) {
+                return !e.m_result;
+            }
+            s.erase(at + 1);
+            return e.m_result;
+        case take_snapshot:
+            return e.m_result == contents_hash(s.begin(), s.end());
+        }
+        return false;
+    }
+    static const char *name_of(unsigned op) {
+        static const char *const names[] = { "push_front", "try_pop_front", "insert_after_if",
+                                             "erase_if_first", "find_if", "remove_if",
+                                             "erase_after", "snapshot" };
+        return names[op];
+    }
+};
+
+void test_checker()
+{
+    printf("--- linearizability checker ---\n");
+    typedef list_model<concurrent_forward_list<int>, stress_mix::list> model;
+    auto ev = [](unsigned op, int arg, int result, uint64_t invoke, uint64_t response) {
+        auto e = stress::event{};
+        e.m_op = op;
+        e.m_arg = e.m_arg2 = arg;
+        e.m_result = result;
+        e.m_invoke = invoke;
+        e.m_response = response;
+        return e;
+    };
+    auto empty = std::vector<int>{};
+    // push(1) before push(2), so a pop after both must see 2
+    auto history = std::vector<stress::event>{ ev(push, 1, 0, 0, 1), ev(push, 2, 0, 2, 3), ev(pop, 0, 1, 4, 5) };
+    assert(!stress::linearizable(history, empty, &model::apply));
+    // Had the pushes overlapped, either order is fine
+    history[0].m_response = 3;
+    assert(stress::linearizable(history, empty, &model::apply));
+    // A pop overlapping a push may see the list empty or not
+    history = { ev(push, 1, 0, 0, 3), ev(pop, 0, Empty, 1, 2), ev(pop, 0, 1, 4, 5) };
+    assert(stress::linearizable(history, empty, &model::apply));
+    history[1].m_result = 1;
+    history[2].m_result = Empty;
+    assert(stress::linearizable(history, empty, &model::apply));
+    // But a value is popped once
+    history[2].m_result = 1;
+    assert(!stress::linearizable(history, empty, &model::apply));
+    // An erased element is not found any more
+    history = { ev(erase, 7, 1, 0, 1), ev(contains, 7, 1, 2, 3) };
+    assert(!stress::linearizable(history, std::vector<int>{ 7 }, &model::apply));
+    history[1].m_invoke = 0;
+    assert(stress::linearizable(history, std::vector<int>{ 7 }, &model::apply));
+    // remove_if() of one key removes it once
+    history = { ev(remove_key, 7, 1, 0, 2), ev(remove_key, 7, 1, 1, 3) };
+    assert(!stress::linearizable(history, std::vector<int>{ 7 }, &model::apply));
+    history[1].m_result = 0;
+    assert(stress::linearizable(history, std::vector<int>{ 7 }, &model::apply));
+    // erase_after() behind the last element or an erased one fails
+    history = { ev(erase_next, 7, 1, 0, 1) };
+    assert(!stress::linearizable(history, std::vector<int>{ 8, 7 }, &model::apply));
+    history = { ev(erase, 7, 1, 0, 1), ev(erase_next, 7, 1, 2, 3) };
+    assert(!stress::linearizable(history, std::vector<int>{ 7, 8 }, &model::apply));
+    history[1].m_invoke = 0;
+    assert(stress::linearizable(history, std::vector<int>{ 7, 8 }, &model::apply));
+    printf("accepts and rejects known histories: pass\n");
+}
+
+// Pops by peeking at the front and popping in a second step, so two
+// threads popping at once may both return the same value
+class peek_then_pop_list : public concurrent_forward_list<int>
+{
+public:
+    std::optional<int> try_pop_front() {
+        auto it = cbegin();
+        if (it == cend()) {
+            return std::nullopt;
+        }
+        auto v = *it;
+        std::this_thread::yield();
+        pop_front();
+        return v;
+    }
+};
+
+void test_faulty_subject()
+{
+    printf("--- peek-then-pop subject ---\n");
+    peek_then_pop_list lst;
+    for (auto i = PrefillCount; i > 0; --i) {
+        lst.push_front(i);
+    }
+    auto r = stress::run<list_model<peek_then_pop_list, stress_mix::stack>>(lst, 4, std::chrono::seconds{ 10 }, 1);
+    assert(!r.m_linearizable);
+    printf("reported after %zu rounds: pass\n", r.m_rounds);
+}
+
+// Snapshots runs the snapshot mix too, for versioned lists
+template<typename List, contention Contention = contention::backoff, bool Snapshots = false>
+void test_stress(const char *name, const stress::options &opts)
+{
+    printf("--- %s ---\n", name);
+    auto run_mix = [&](const char *mix, auto model) {
+        typedef decltype(model) model_type;
+        if (!opts.wants_mix(mix)) {
+            return;
+        }
+        for (auto threads : opts.thread_counts()) {
+            List lst{ Contention };
+            for (auto i = PrefillCount; i > 0; --i) {
+                lst.push_front(i);
+            }
+            auto r = stress::run<model_type>(lst, threads, opts.m_duration, opts.m_seed);
+            assert(r.m_linearizable);
+            printf("%s, %u threads, %zu rounds, %zu ops: pass\n", mix, threads, r.m_rounds, r.m_ops);
+        }
+    };
+    run_mix("stack", list_model<List, stress_mix::stack>{});
+    run_mix("list", list_model<List, stress_mix::list>{});
+    if constexpr (Snapshots) {
+        run_mix("snapshot", list_model<List, stress_mix::snapshot>{});
+    }
+}
+
+int main(int argc, char **argv)
+{
+    auto opts = stress::options{ argc, argv };
+    test_checker();
+    test_faulty_subject();
+    test_stress<concurrent_forward_list<int, epoch_reclaimer>>("locking_policy, epoch_reclaimer", opts);
+    test_stress<concurrent_forward_list<int, hazard_pointer_reclaimer>>("locking_policy, hazard_pointer_reclaimer", opts);
+    test_stress<concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, lock_free_policy>>(
+        "lock_free_policy, epoch_reclaimer", opts);
+    test_stress<concurrent_forward_list<int, hazard_pointer_reclaimer, std::allocator<int>, lock_free_policy>>(
+        "lock_free_policy, hazard_pointer_reclaimer", opts);
+    test_stress<concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, lock_free_policy>,
+                contention::elimination>("lock_free_policy, epoch_reclaimer, elimination", opts);
+    test_stress<concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, locking_policy,
+                                        no_stats, compact_layout, versioned_nodes>,
+                contention::backoff, true>(
+        "locking_policy, epoch_reclaimer, versioned_nodes", opts);
+    test_stress<concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, lock_free_policy,
+                                        no_stats, compact_layout, versioned_nodes>,
+                contention::backoff, true>(
+        "lock_free_policy, epoch_reclaimer, versioned_nodes", opts);
+    epoch_reclaimer::collect();
+    hazard_pointer_reclaimer::collect();
+}
@@ -1,9 +1,17 @@
 #include "concurrent_forward_list.hpp"
+#include "node_pool.hpp"
 #include <thread>
 #include <stdio.h>
 #include <numeric>
 #include <atomic>
 #include <cassert>
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <optional>
 
 #define BUGGY_PART 1
 
@@ -21,9 +29,14 @@ size_t list_size(const list_type &lst) {
 std::atomic<int> PopTimes{ 20 }, PushTimes{ 10 };
 std::atomic<int> InsertTimes{ 30 }, EraseTimes{ 20 };
 
-int main()
+template< typename Reclaimer, 
+          typename Allocator = std::allocator<int>, 
+          typename SyncPolicy = locking_policy>
+void test_list(const char *name)
 {
-    concurrent_forward_list<int> cflist{};
+    printf("--- %s ---\n", name);
+    typedef concurrent_forward_list<int, Reclaimer, Allocator, SyncPolicy> list_type;
+    list_type cflist{};
     
     // push_front
     constexpr auto Max = 100;
@@ -44,14 +57,16 @@ int main()
     printf("pop_front: pass\n");
 
     // simultaneous push_front() and pop_front()
+    PopTimes.store(20);
+    PushTimes.store(10);
     size_t ElementsLeftCount = Max - PopTimes.load() + PushTimes.load();
-    auto pop = [](concurrent_forward_list<int> *plst) {
+    auto pop = [](list_type *plst) {
         while (PopTimes.load(std::memory_order_acquire)) {
             plst->pop_front();
             PopTimes.fetch_sub(1, std::memory_order_acq_rel);
         }
     };
-    auto push = [](concurrent_forward_list<int> *plst) {
+    auto push = [](list_type *plst) {
         auto i = 0;
         while ( (i = PushTimes.load(std::memory_order_acquire)) ) {
             plst->push_front(i);
@@ -63,6 +78,7 @@ int main()
     t1.join();
     t2.join();
     assert(list_size(cflist) == ElementsLeftCount);
+    assert(cflist.size() == ElementsLeftCount);
     printf("simultaneous push_front() and pop_front(): pass\n");
 
     // insert_after()
@@ -79,7 +95,7 @@ int main()
      for (auto i = 0; i < 100; ++i) {
         assert(*beg++ == i);
     }
-    assert(list_size(cflist) == 100);
+    assert(list_size(cflist) == 100 && cflist.size() == 100);
     printf("insert_after(): pass\n");
 
     // erase_after()
@@ -91,7 +107,7 @@ int main()
         }
     }
     assert(*beg == 0);
-    assert(list_size(cflist) == 1);
+    assert(list_size(cflist) == 1 && cflist.size() == 1);
     printf("erase_after(): pass\n");
 
     // simultaneous insert_after() and erase_after()   
@@ -103,7 +119,7 @@ int main()
     ElementsLeftCount = list_size(cflist) 
                         + InsertTimes.load()
                         - EraseTimes.load();
-	auto eraser = [](concurrent_forward_list<int> *plst) {
+	auto eraser = [](list_type *plst) {
 		while (EraseTimes.load(std::memory_order_acquire)) {
 			if (plst->erase_after(plst->cbegin())) {
                 printf( "erase: %d\n", 
@@ -111,7 +127,7 @@ int main()
             }					
 		}
 	};
-	auto insertor = [](concurrent_forward_list<int> *plst) {		
+	auto insertor = [](list_type *plst) {		
 		auto i = 0;
 		while ((i = InsertTimes.load(std::memory_order_acquire))) {
             auto after_head = ++plst->cbegin();
@@ -128,5 +144,1163 @@ int main()
     auto actual_sz = list_size(cflist);
     printf("actual: %lu\nexpected: %lu\n", actual_sz, ElementsLeftCount);
     assert(actual_sz == ElementsLeftCount);
+    assert(cflist.size() == actual_sz && cflist.approx_size() == actual_sz);
     printf("simultaneous insert_after() and erase_after(): pass\n");
+
+    // clear()
+    cflist.clear();
+    assert(cflist.empty() && cflist.size() == 0);
+    assert(!beg.is_valid());
+    Reclaimer::collect();
+    printf("clear(): pass\n");
+}
+
+template<typename SyncPolicy>
+void test_try_pop(const char *name)
+{
+    printf("--- try_pop_front(), %s ---\n", name);
+    concurrent_forward_list<std::string, epoch_reclaimer, std::allocator<std::string>, SyncPolicy> slist{};
+    assert(!slist.try_pop_front());
+    auto s = std::string{};
+    assert(!slist.try_pop_front(s));
+
+    slist.push_front("first");
+    slist.push_front("second");
+    auto v = slist.try_pop_front();
+    assert(v && *v == "second");
+    assert(slist.try_pop_front(s) && s == "first");
+    assert(slist.empty());
+    printf("try_pop_front(): pass\n");
+
+    // Every pushed value is popped exactly once
+    concurrent_forward_list<int, hazard_pointer_reclaimer, std::allocator<int>, SyncPolicy> ilist{};
+    constexpr auto Count = 10000;
+    std::atomic<long> popped_sum{ 0 };
+    std::atomic<int> popped_count{ 0 };
+    auto producer = [&ilist] {
+        for (auto i = 1; i <= Count; ++i) {
+            ilist.push_front(i);
+        }
+    };
+    auto consumer = [&] {
+        auto i = 0;
+        while (popped_count.load() < Count) {
+            if (ilist.try_pop_front(i)) {
+                popped_sum.fetch_add(i);
+                popped_count.fetch_add(1);
+            }
+        }
+    };
+    std::thread t1{ producer };
+    std::thread t2{ consumer };
+    std::thread t3{ consumer };
+    t1.join();
+    t2.join();
+    t3.join();
+    assert(popped_sum.load() == long{ Count } * (Count + 1) / 2);
+    assert(ilist.empty());
+    printf("simultaneous push_front() and try_pop_front(): pass\n");
+
+    // Popping leaves the value intact for readers still at the node:
+    // strings too long for the small buffer would lose it to a move
+    auto text = [](int i) { return std::string(64, static_cast<char>('a' + i % 26)); };
+    for (auto i = 0; i < 16; ++i) {
+        slist.push_front(text(i));
+    }
+    auto done = std::atomic<bool>{ false };
+    std::thread popper{ [&] {
+        for (auto i = 0; i < Count; ++i) {
+            auto v = slist.try_pop_front();
+            assert(v && v->size() == 64);
+            slist.push_front(text(i));
+        }
+        done = true;
+    } };
+    while (!done) {
+        slist.for_each([&text](const std::string &v) {
+            assert(v == text(v[0] - 'a'));
+        });
+    }
+    popper.join();
+    slist.clear();
+    epoch_reclaimer::collect();
+    printf("simultaneous try_pop_front() and for_each(): pass\n");
+}
+
+// Counts the copies made of it
+struct copy_counted
+{
+    static int  copies;
+    int         m_key;
+    std::string m_name;
+
+    copy_counted(int key, std::string name) : m_key(key), m_name(std::move(name)) {}
+    copy_counted(const copy_counted &oth) : m_key(oth.m_key), m_name(oth.m_name) { ++copies; }
+    copy_counted(copy_counted &&) = default;
+};
+int copy_counted::copies = 0;
+
+template<typename SyncPolicy>
+void test_emplace(const char *name)
+{
+    printf("--- emplace_front(), emplace_after(), %s ---\n", name);
+    copy_counted::copies = 0;
+    concurrent_forward_list<copy_counted, epoch_reclaimer, std::allocator<copy_counted>, SyncPolicy> slist{};
+    slist.emplace_front(3, "three");
+    slist.push_front(copy_counted{ 1, "one" });
+    auto it = slist.cbegin();
+    assert(slist.emplace_after(it, 2, "two"));
+    assert(slist.insert_after(it, copy_counted{ 0, "zero" }));
+    assert(copy_counted::copies == 0);
+
+    // 1 -> 0 -> 2 -> 3
+    const int expected[] = { 1, 0, 2, 3 };
+    auto i = 0;
+    for (auto beg = slist.cbegin(); beg.is_valid(); ++beg) {
+        assert(beg->m_key == expected[i++]);
+    }
+    assert(i == 4);
+    printf("construct in place: pass\n");
+
+    auto v = copy_counted{ 4, "four" };
+    slist.push_front(v);
+    assert(copy_counted::copies == 1);
+    assert(slist.cbegin()->m_name == "four" && v.m_name == "four");
+    printf("push_front() copy: pass\n");
+}
+
+template<typename SyncPolicy>
+void test_range(const char *name)
+{
+    printf("--- push_front_range(), insert_after_range(), %s ---\n", name);
+    concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, SyncPolicy> slist{};
+    const int front[] = { 1, 2, 3 };
+    const int middle[] = { 7, 8 };
+    slist.push_front_range(front, front);
+    assert(slist.empty());
+    slist.push_front_range(front, front + 3);
+    auto it = slist.cbegin();
+    assert(slist.insert_after_range(it, middle, middle + 2));
+    slist.push_front_range(middle, middle + 1);
+
+    // 7 -> 1 -> 7 -> 8 -> 2 -> 3
+    const int expected[] = { 7, 1, 7, 8, 2, 3 };
+    auto i = 0;
+    for (auto beg = slist.cbegin(); beg.is_valid(); ++beg) {
+        assert(*beg == expected[i++]);
+    }
+    assert(i == 6);
+
+    // Erased position rejects the whole batch
+    auto pre = slist.cbegin();
+    auto pos = pre;
+    ++pos;
+    assert(slist.erase_after(pre));
+    assert(!slist.insert_after_range(pos, middle, middle + 2));
+    assert(!slist.insert_after_range(pos, middle, middle));
+    printf("order and position: pass\n");
+
+    // Every element of every batch shows up
+    concurrent_forward_list<int, hazard_pointer_reclaimer, std::allocator<int>, SyncPolicy> ilist{};
+    constexpr auto Batches = 1000, BatchSize = 16;
+    auto producer = [&ilist](int base) {
+        int batch[BatchSize];
+        for (auto b = 0; b < Batches; ++b) {
+            for (auto k = 0; k < BatchSize; ++k) {
+                batch[k] = base + b * BatchSize + k;
+            }
+            ilist.push_front_range(batch, batch + BatchSize);
+        }
+    };
+    std::thread t1{ producer, 0 };
+    std::thread t2{ producer, Batches * BatchSize };
+    t1.join();
+    t2.join();
+    auto count = 0;
+    auto sum = 0l;
+    for (auto beg = ilist.cbegin(); beg.is_valid(); ++beg) {
+        ++count;
+        sum += *beg;
+    }
+    constexpr auto Total = 2 * Batches * BatchSize;
+    assert(count == Total);
+    assert(sum == long{ Total } * (Total - 1) / 2);
+    printf("simultaneous push_front_range(): pass\n");
+}
+
+template<typename Reclaimer, typename SyncPolicy>
+void test_take_all(const char *name)
+{
+    printf("--- take_all(), %s ---\n", name);
+    typedef concurrent_forward_list<std::string, Reclaimer, std::allocator<std::string>, SyncPolicy> list_type;
+    list_type slist{};
+    assert(slist.take_all().empty());
+    slist.push_front("c");
+    slist.push_front("b");
+    slist.push_front("a");
+    auto it = slist.cbegin();
+    auto taken = slist.take_all();
+    assert(slist.empty());
+    assert(!it.is_valid());
+    assert(!slist.insert_after(it, "x"));
+    assert(!slist.erase_after(it));
+    auto joined = std::string{};
+    for (auto &s : taken) {
+        joined += std::move(s);
+    }
+    assert(joined == "abc");
+    printf("take_all(): pass\n");
+
+    // Every pushed value is either popped or drained, exactly once
+    concurrent_forward_list<int, Reclaimer, std::allocator<int>, SyncPolicy> ilist{};
+    constexpr auto Count = 10000;
+    std::atomic<long> popped_sum{ 0 };
+    auto producer = [&] {
+        auto v = 0;
+        for (auto i = 1; i <= Count; ++i) {
+            ilist.push_front(i);
+            if (i % 4 == 0 && ilist.try_pop_front(v)) {
+                popped_sum.fetch_add(v);
+            }
+        }
+    };
+    std::atomic<bool> done{ false };
+    std::atomic<long> drained_sum{ 0 };
+    auto consumer = [&] {
+        auto drain = [&] {
+            auto sum = 0l;
+            for (auto v : ilist.take_all()) {
+                sum += v;
+            }
+            drained_sum.fetch_add(sum);
+        };
+        while (!done.load()) {
+            drain();
+        }
+        drain();
+    };
+    std::thread t1{ producer };
+    std::thread t2{ producer };
+    std::thread t3{ consumer };
+    t1.join();
+    t2.join();
+    done.store(true);
+    t3.join();
+    assert(ilist.empty());
+    assert(popped_sum.load() + drained_sum.load() == 2l * Count * (Count + 1) / 2);
+    printf("simultaneous push_front() and take_all(): pass\n");
+    Reclaimer::collect();
+}
+
+template<typename Reclaimer>
+void test_teardown(const char *name)
+{
+    printf("--- teardown, %s ---\n", name);
+    typedef concurrent_forward_list<int, Reclaimer> list_type;
+    constexpr auto Count = 300000;
+    for (auto mode : { teardown::caller, teardown::background }) {
+        {
+            list_type slist{ mode };
+            for (auto i = 0; i < Count; ++i) {
+                slist.push_front(i);
+            }
+            auto it = slist.cbegin();
+            slist.clear();
+            assert(slist.empty());
+            background_reclaimer::instance().drain();
+            assert(!it.is_valid());
+            assert(!slist.insert_after(it, -1));
+
+            // Destroyed with a long chain in it
+            for (auto i = 0; i < Count; ++i) {
+                slist.push_front(i);
+            }
+        }
+        background_reclaimer::instance().drain();
+        Reclaimer::collect();
+    }
+    printf("clear() and destructor of long lists: pass\n");
+}
+
+template<typename Reclaimer, typename SyncPolicy>
+void test_elimination(const char *name)
+{
+    printf("--- contention::elimination, %s ---\n", name);
+
+    // Nodes offered by one thread are taken by the other, exactly once
+    struct node { int m_val; };
+    auto array = detail::elimination_array<node>{};
+    auto tmp = node{ 0 };
+    assert(!array.take());
+    constexpr auto Offers = 2000;
+    std::atomic<int> handed{ 0 };
+    std::atomic<int> taken{ 0 };
+    std::atomic<bool> done{ false };
+    std::thread offerer{ [&] {
+        for (auto i = 0; i < Offers; ++i) {
+            handed += array.offer(&tmp);
+        }
+        done.store(true);
+    } };
+    std::thread taker{ [&] {
+        while (!done.load()) {
+            if (auto p = array.take()) {
+                assert(p == &tmp);
+                ++taken;
+            }
+        }
+    } };
+    offerer.join();
+    taker.join();
+    assert(handed.load() == taken.load());
+    printf("elimination_array: pass\n");
+
+    // Every pushed value is either popped or left in the list, exactly once
+    concurrent_forward_list<int, Reclaimer, std::allocator<int>, SyncPolicy> ilist{ contention::elimination };
+    constexpr auto Count = 20000;
+    std::atomic<long> popped_sum{ 0 };
+    auto worker = [&] {
+        auto v = 0;
+        for (auto i = 1; i <= Count; ++i) {
+            ilist.push_front(i);
+            if (i % 2 == 0 && ilist.try_pop_front(v)) {
+                popped_sum.fetch_add(v);
+            }
+        }
+    };
+    std::thread t1{ worker };
+    std::thread t2{ worker };
+    std::thread t3{ worker };
+    t1.join();
+    t2.join();
+    t3.join();
+    auto left_sum = 0l;
+    for (auto v : ilist.take_all()) {
+        left_sum += v;
+    }
+    assert(popped_sum.load() + left_sum == 3l * Count * (Count + 1) / 2);
+    printf("simultaneous push_front() and try_pop_front(): pass\n");
+    Reclaimer::collect();
+}
+
+template<typename Reclaimer, typename SyncPolicy>
+void test_size(const char *name)
+{
+    printf("--- size(), %s ---\n", name);
+    typedef concurrent_forward_list<int, Reclaimer, std::allocator<int>, SyncPolicy> list_type;
+
+    // Every modifier keeps the count
+    list_type slist{};
+    assert(slist.size() == 0 && slist.approx_size() == 0);
+    int vals[] = { 1, 2, 3, 4 };
+    slist.push_front_range(vals, vals + 4);
+    slist.emplace_front(0);
+    assert(slist.size() == 5);
+    auto it = slist.cbegin();
+    assert(slist.insert_after_range(it, vals, vals + 2) && slist.size() == 7);
+    assert(slist.erase_after(it) && slist.size() == 6);
+    slist.pop_front();
+    assert(slist.size() == 5 && !slist.erase_after(it) && slist.size() == 5);
+    auto taken = slist.take_all();
+    assert(slist.size() == 0);
+    slist.push_front(1);
+    assert(slist.size() == 1);
+    printf("modifiers: pass\n");
+
+    // The count matches the list once concurrent modifiers are done,
+    // also when the background_reclaimer clears
+    list_type blist{ teardown::background };
+    constexpr auto Count = 5000;
+    std::atomic<bool> done{ false };
+    auto modifier = [&] {
+        for (auto i = 0; i < Count; ++i) {
+            blist.push_front(i);
+            blist.insert_after(blist.cbegin(), i);
+            if (i % 3 == 0) {
+                blist.pop_front();
+            }
+            if (i % 5 == 0) {
+                blist.erase_after(blist.cbegin());
+            }
+        }
+    };
+    auto clearer = [&] {
+        while (!done.load()) {
+            assert(blist.approx_size() <= 4 * Count);
+            if (blist.size() > Count) {
+                blist.clear();
+            }
+        }
+    };
+    std::thread c{ clearer };
+    std::thread t1{ modifier };
+    std::thread t2{ modifier };
+    t1.join();
+    t2.join();
+    done.store(true);
+    c.join();
+    background_reclaimer::instance().drain();
+    assert(blist.size() == list_size(blist));
+    blist.clear();
+    background_reclaimer::instance().drain();
+    assert(blist.size() == 0);
+    printf("simultaneous modifiers and clear(): pass\n");
+
+    // The stripes are allocated once a second thread updates
+    auto counter = detail::striped_counter{};
+    counter.add(3);
+    counter.sub(1);
+    assert(!counter.is_striped() && counter.exact() == 2);
+    std::thread second{ [&counter] { counter.add(5); } };
+    second.join();
+    assert(counter.is_striped() && counter.exact() == 7 && counter.approx() == 7);
+    printf("stripes on a second thread's update: pass\n");
+    Reclaimer::collect();
+}
+
+template<typename Reclaimer, typename SyncPolicy>
+void test_for_each(const char *name)
+{
+    printf("--- for_each(), %s ---\n", name);
+    typedef concurrent_forward_list<int, Reclaimer, std::allocator<int>, SyncPolicy> list_type;
+    list_type ilist{};
+    auto sum = 0;
+    ilist.for_each([&](int v) { sum += v; });
+    assert(sum == 0 && ilist.find_if([](int) { return true; }) == ilist.end());
+    for (auto i = 1; i <= 100; ++i) {
+        ilist.push_front(i);
+    }
+    ilist.for_each([](int &v) { v *= 2; });
+    std::as_const(ilist).for_each([&](const int &v) { sum += v; });
+    assert(sum == 100 * 101);
+    auto it = ilist.find_if([](int v) { return v < 100; });
+    assert(it != ilist.end() && *it == 98);
+    assert(ilist.erase_after(it) && *std::as_const(ilist).find_if([](int v) { return v < 100; }) == 98);
+    assert(ilist.find_if([](int v) { return v == 96; }) == ilist.end());
+    printf("for_each(), find_if(): pass\n");
+
+    // Scans see the elements that stay, exactly once, while others
+    // come and go around them
+    constexpr auto Stable = 100;
+    constexpr auto Count = 5000;
+    list_type slist{};
+    for (auto i = 0; i < Stable; ++i) {
+        slist.push_front(-1);
+    }
+    std::atomic<bool> done{ false };
+    // Only the nodes pushed by a writer get a successor inserted and
+    // erased, and there are never more pops than pushes
+    auto writer = [&](int id) {
+        for (auto i = 0; i < Count; ++i) {
+            auto v = i * 2 + id;
+            slist.push_front(v);
+            auto it = slist.find_if([v](int x) { return x == v; });
+            if (it != slist.end() && slist.insert_after(it, v)) {
+                slist.erase_after(it);
+            }
+            slist.pop_front();
+        }
+    };
+    auto reader = [&] {
+        while (!done.load()) {
+            auto stable = 0;
+            slist.for_each([&](int v) { stable += v == -1; });
+            // With hazard pointers a scan standing on a node that gets
+            // erased ends early
+            assert(stable == Stable || (!Reclaimer::covers_unlinked_nodes && stable < Stable));
+            auto it = slist.find_if([](int v) { return v < 0; });
+            assert(it == slist.end() ? !Reclaimer::covers_unlinked_nodes : *it == -1);
+        }
+    };
+    std::thread r{ reader };
+    std::thread w1{ writer, 0 };
+    std::thread w2{ writer, 1 };
+    w1.join();
+    w2.join();
+    done.store(true);
+    r.join();
+    auto stable = 0;
+    slist.for_each([&](int v) { stable += v == -1; });
+    assert(stable == Stable);
+    printf("simultaneous for_each() and modifiers: pass\n");
+    Reclaimer::collect();
+}
+
+template<typename Reclaimer, typename SyncPolicy>
+void test_positional(const char *name)
+{
+    printf("--- insert_after_if(), erase_if_first(), %s ---\n", name);
+    typedef concurrent_forward_list<int, Reclaimer, std::allocator<int>, SyncPolicy> list_type;
+    list_type ilist{};
+    int vals[] = { 1, 2, 3, 4, 5 };
+    ilist.push_front_range(vals, vals + 5);
+    assert(ilist.insert_after_if([](int v) { return v == 3; }, 30));
+    assert(ilist.emplace_after_if([](int v) { return v == 5; }, 50));
+    assert(!ilist.insert_after_if([](int v) { return v > 100; }, 0));
+    auto joined = std::string{};
+    ilist.for_each([&](int v) { joined += std::to_string(v) + ' '; });
+    assert(joined == "1 2 3 30 4 5 50 ");
+    // The head, the middle and the tail
+    assert(ilist.erase_if_first([](int v) { return v == 1; }));
+    assert(ilist.erase_if_first([](int v) { return v >= 30; }));
+    assert(ilist.erase_if_first([](int v) { return v == 50; }));
+    assert(!ilist.erase_if_first([](int v) { return v == 50; }));
+    joined.clear();
+    ilist.for_each([&](int v) { joined += std::to_string(v) + ' '; });
+    assert(joined == "2 3 4 5 " && ilist.size() == 4);
+    printf("insert_after_if(), erase_if_first(): pass\n");
+
+    // Stable positions are always found, and each thread's own values are
+    // always erased, while churn erases the nodes searches pass through
+    constexpr auto Stable = 64;
+    constexpr auto Threads = 3;
+    constexpr auto Count = 3000;
+    list_type slist{};
+    for (auto i = 0; i < Stable; ++i) {
+        slist.push_front(i);
+    }
+    std::atomic<bool> done{ false };
+    std::thread churn{ [&] {
+        while (!done.load()) {
+            slist.push_front(-1);
+            assert(slist.insert_after_if([](int v) { return v == Stable / 2; }, -1));
+            assert(slist.erase_if_first([](int v) { return v < 0; }));
+            assert(slist.erase_if_first([](int v) { return v < 0; }));
+        }
+    } };
+    auto threads = std::vector<std::thread>{};
+    for (auto t = 0; t < Threads; ++t) {
+        threads.emplace_back([&slist, t] {
+            for (auto i = 0; i < Count; ++i) {
+                auto mine = Stable + t * Count + i;
+                assert(slist.insert_after_if([i](int v) { return v == i % Stable; }, mine));
+                assert(slist.erase_if_first([mine](int v) { return v == mine; }));
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    done.store(true);
+    churn.join();
+    assert(slist.size() == Stable && list_size(slist) == Stable);
+    printf("simultaneous insert_after_if() and erase_if_first(): pass\n");
+    Reclaimer::collect();
+}
+
+template<typename Reclaimer, typename SyncPolicy>
+void test_remove_if(const char *name)
+{
+    printf("--- remove_if(), %s ---\n", name);
+    typedef concurrent_forward_list<int, Reclaimer, std::allocator<int>, SyncPolicy> list_type;
+    list_type ilist{};
+    assert(ilist.remove_if([](int) { return true; }) == 0);
+    // Runs at the head, in the middle, longer than RunLimit and at the tail
+    constexpr auto Count = 4 * static_cast<int>(list_type::RunLimit);
+    for (auto i = Count; i > 0; --i) {
+        ilist.push_front(i);
+    }
+    auto in_run = [](int v) { return v <= 3 || (v > 10 && v <= 10 + Count / 2) || v > Count - 5; };
+    auto kept = 0;
+    for (auto i = 1; i <= Count; ++i) {
+        kept += !in_run(i);
+    }
+    assert(ilist.remove_if(in_run) == static_cast<size_t>(Count - kept));
+    assert(ilist.size() == static_cast<size_t>(kept) && list_size(ilist) == static_cast<size_t>(kept));
+    auto expected = 4;
+    for (auto v : ilist.take_all()) {
+        assert(v == expected);
+        expected = expected == 10 ? 11 + Count / 2 : expected + 1;
+    }
+    assert(expected == Count - 4);
+    for (auto i = 0; i < 10; ++i) {
+        ilist.push_front(i);
+    }
+    assert(ilist.remove_if([](int) { return true; }) == 10 && ilist.empty());
+    printf("remove_if(): pass\n");
+
+    // Every even value pushed is removed exactly once, odd ones are kept
+    constexpr auto Stable = 200;
+    constexpr auto Pushes = 20000;
+    list_type slist{};
+    for (auto i = 0; i < Stable; ++i) {
+        slist.push_front(2 * i + 1);
+    }
+    std::atomic<bool> done{ false };
+    std::atomic<long> removed{ 0 };
+    std::thread pusher{ [&] {
+        for (auto i = 0; i < Pushes; ++i) {
+            slist.push_front(0);
+            assert(slist.insert_after_if([i](int v) { return v == 2 * (i % Stable) + 1; }, 2));
+            if (i % 64 == 0 && slist.erase_if_first([](int v) { return v % 2 == 0; })) {
+                removed += 1;
+            }
+        }
+        done.store(true);
+    } };
+    auto purge = [&] {
+        while (!done.load()) {
+            removed += slist.remove_if([](int v) { return v % 2 == 0; });
+        }
+    };
+    std::thread p1{ purge };
+    std::thread p2{ purge };
+    pusher.join();
+    p1.join();
+    p2.join();
+    removed += slist.remove_if([](int v) { return v % 2 == 0; });
+    assert(removed.load() == 2l * Pushes);
+    assert(slist.size() == Stable && list_size(slist) == Stable);
+    printf("simultaneous remove_if() and modifiers: pass\n");
+    Reclaimer::collect();
+}
+
+template<typename SyncPolicy>
+void test_stats(const char *name)
+{
+    printf("--- stats, %s ---\n", name);
+    // The policy doubles as the Tag, so each run counts on its own
+    typedef thread_stats<SyncPolicy> stats;
+    typedef concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, SyncPolicy, stats> list_type;
+    static_assert(!no_stats::enabled && stats::enabled);
+    list_type ilist{};
+    auto before = stats::thread_snapshot();
+    ilist.push_front(1);
+    ilist.push_front(2);
+    auto range = { 3, 4 };
+    ilist.push_front_range(range.begin(), range.end());
+
+    // A position erased under an insertion or erasure makes it fail stale
+    auto pos = ilist.cbegin();
+    ++pos;
+    assert(*pos == 4);
+    assert(ilist.erase_after(ilist.cbegin()));
+    assert(!ilist.insert_after(pos, 5) && !ilist.erase_after(pos));
+    ilist.pop_front();
+    assert(ilist.try_pop_front() == 2);
+
+    auto s = stats::thread_snapshot() - before;
+    auto &push = s[list_op::push_front];
+    assert(push.m_calls == 3 && push.m_cas_attempts == push.m_calls + push.m_cas_failures);
+    assert(s[list_op::pop_front].m_calls == 2 && s[list_op::pop_front].m_stale == 0);
+    assert(s[list_op::insert_after].m_calls == 1 && s[list_op::insert_after].m_stale == 1);
+    assert(s[list_op::erase_after].m_calls == 2 && s[list_op::erase_after].m_stale == 1);
+    for (auto &o : s.m_ops) {
+        assert(o.m_cas_failures <= o.m_cas_attempts && o.m_lock_waits == 0 && o.m_lock_wait_ns == 0);
+    }
+    printf("thread_snapshot(): pass\n");
+
+    // The counts of exited threads stay in the snapshot
+    constexpr auto Threads = 4;
+    constexpr auto Count = 5000;
+    before = stats::snapshot();
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < Threads; ++i) {
+        threads.emplace_back([&ilist] {
+            for (auto j = 0; j < Count; ++j) {
+                ilist.push_front(j);
+                ilist.pop_front();
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    s = stats::snapshot() - before;
+    assert(s[list_op::push_front].m_calls == Threads * Count);
+    assert(s[list_op::pop_front].m_calls == Threads * Count);
+    assert(s[list_op::push_front].m_cas_attempts >= s[list_op::push_front].m_calls);
+    assert(ilist.size() == 1 && *ilist.cbegin() == 1);
+    printf("snapshot(): pass\n");
+    epoch_reclaimer::collect();
+}
+
+template<typename SyncPolicy>
+void test_layout(const char *name)
+{
+    printf("--- layout, %s ---\n", name);
+    typedef concurrent_forward_list<int, epoch_reclaimer, node_pool_allocator<int>, SyncPolicy, no_stats, split_layout> list_type;
+    // Lists side by side keep their heads on separate cache lines
+    static_assert(alignof(list_type) == detail::cache_line_size);
+    static_assert(alignof(concurrent_forward_list<int>) == detail::cache_line_size);
+    list_type lists[2];
+    assert(reinterpret_cast<std::uintptr_t>(&lists[1]) - reinterpret_cast<std::uintptr_t>(&lists[0]) >= detail::cache_line_size);
+
+    // Values start a line apart from the links
+    auto &ilist = lists[0];
+    for (auto i = 0; i < 3; ++i) {
+        ilist.push_front(i);
+    }
+    assert(ilist.insert_after(ilist.cbegin(), 7) && ilist.erase_after(ilist.cbegin()));
+    for (auto it = ilist.cbegin(); it != ilist.cend(); ++it) {
+        assert(reinterpret_cast<std::uintptr_t>(&*it) % detail::cache_line_size == 0);
+    }
+    printf("split_layout: pass\n");
+
+    constexpr auto Threads = 4;
+    constexpr auto Count = 5000;
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < Threads; ++i) {
+        threads.emplace_back([&lists, i] {
+            auto &l = lists[i % 2];
+            for (auto j = 0; j < Count; ++j) {
+                l.push_front(j);
+                l.erase_after(l.cbegin());
+                l.pop_front();
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    assert(lists[0].size() == list_size(lists[0]) && lists[1].size() == list_size(lists[1]));
+    printf("simultaneous modifiers on adjacent lists: pass\n");
+    epoch_reclaimer::collect();
+}
+
+template<typename SyncPolicy>
+void test_snapshot(const char *name)
+{
+    printf("--- snapshot, %s ---\n", name);
+    typedef concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, SyncPolicy,
+                                    no_stats, compact_layout, versioned_nodes> list_type;
+    list_type ilist;
+    for (auto i = 0; i < 5; ++i) {
+        ilist.push_front(i);
+    }
+    auto snap = ilist.snapshot();
+    ilist.pop_front();
+    assert(ilist.insert_after(ilist.cbegin(), 7) && ilist.erase_after(ilist.cbegin()));
+    ilist.push_front(8);
+    auto expected = std::vector<int>{ 4, 3, 2, 1, 0 };
+    assert(std::equal(snap.begin(), snap.end(), expected.begin(), expected.end()));
+    auto later = ilist.snapshot();
+    expected = { 8, 3, 2, 1, 0 };
+    assert(later.version() > snap.version());
+    assert(std::equal(later.begin(), later.end(), expected.begin(), expected.end()));
+    assert(ilist.try_pop_front() == 8 && ilist.remove_if([](int v) { return v < 2; }) == 2);
+    ilist.clear();
+    assert(ilist.snapshot().empty() && later.size() == 5);
+    printf("point in time copy: pass\n");
+
+    // Stable elements 0..Stable-1, writers insert and erase markers, each
+    // keeping at most one in the list at any time. A torn view could hold
+    // a writer's marker together with the one it inserted after erasing it.
+    constexpr auto Stable = 100;
+    constexpr auto Writers = 3;
+    constexpr auto Count = 2000;
+    for (auto i = 0; i < Stable; ++i) {
+        ilist.push_front(i);
+    }
+    auto marker = [](int writer, int j) { return -(1 + writer + Writers * j); };
+    auto done = std::atomic<int>{ 0 };
+    auto threads = std::vector<std::thread>{};
+    for (auto w = 0; w < Writers - 1; ++w) {
+        threads.emplace_back([&, w] {
+            for (auto j = 0; j < Count; ++j) {
+                auto key = (j * 37 + w * 11) % Stable;
+                auto m = marker(w, j);
+                assert(ilist.insert_after_if([key](int v) { return v == key; }, m));
+                assert(ilist.erase_if_first([m](int v) { return v == m; }));
+            }
+            ++done;
+        });
+    }
+    // The last writer's markers go to the front
+    threads.emplace_back([&] {
+        for (auto j = 0; j < Count; ++j) {
+            ilist.push_front(marker(Writers - 1, j));
+            assert(ilist.try_pop_front() == marker(Writers - 1, j));
+        }
+        ++done;
+    });
+    auto version = uint64_t{ 0 };
+    auto taken = 0;
+    while (done.load() < Writers || taken == 0) {
+        auto s = ilist.snapshot();
+        assert(s.version() > version);
+        version = s.version();
+        int stable = 0, markers[Writers] = {};
+        for (auto v : s) {
+            if (v >= 0) {
+                ++stable;
+            } else {
+                auto writer = (-v - 1) % Writers;
+                assert(++markers[writer] == 1);
+            }
+        }
+        assert(stable == Stable);
+        ++taken;
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    assert(ilist.snapshot().size() == Stable && ilist.size() == Stable);
+    printf("snapshots under simultaneous modifiers: pass\n");
+
+    // A thread that erased an element, or saw it erased, does not find it
+    // in its next snapshot, while others race to erase the same elements
+    constexpr auto Pool = 2000;
+    ilist.clear();
+    for (auto i = 0; i < Pool; ++i) {
+        ilist.push_front(i);
+    }
+    auto absent = [](const typename list_type::list_snapshot &s, int v) {
+        return std::find(s.begin(), s.end(), v) == s.end();
+    };
+    threads.clear();
+    for (auto t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            auto rng = std::mt19937{ static_cast<unsigned>(t) };
+            for (;;) {
+                if (t % 2) {
+                    auto v = ilist.try_pop_front();
+                    if (!v) {
+                        return;
+                    }
+                    assert(absent(ilist.snapshot(), *v));
+                    continue;
+                }
+                // Erased by this thread or found erased by someone else
+                auto k = static_cast<int>(rng() % Pool);
+                if ( ilist.erase_if_first([k](int v) { return v == k; }) ||
+                     ilist.find_if([k](int v) { return v == k; }) == ilist.end() ) {
+                    assert(absent(ilist.snapshot(), k));
+                }
+                if (ilist.empty()) {
+                    return;
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    assert(ilist.snapshot().empty());
+    printf("snapshots after erasures: pass\n");
+    epoch_reclaimer::collect();
+}
+
+#if HUNGBIU_COROUTINES
+// Runs eagerly and frees itself when done
+struct detached_task
+{
+    struct promise_type
+    {
+        detached_task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+template<typename list_type>
+detached_task consume(list_type &ilist, int count, std::atomic<long> &sum, std::atomic<int> &finished)
+{
+    for (auto i = 0; i < count; ++i) {
+        sum += co_await ilist.async_pop_front();
+    }
+    ++finished;
+}
+#endif
+
+template<typename SyncPolicy>
+void test_wait_pop(const char *name)
+{
+    printf("--- wait_pop_front, %s ---\n", name);
+    typedef concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, SyncPolicy> list_type;
+    list_type ilist;
+    auto start = std::chrono::steady_clock::now();
+    assert(!ilist.wait_pop_front(std::chrono::milliseconds{ 10 }));
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds{ 10 });
+    ilist.push_front(1);
+    assert(ilist.wait_pop_front(std::chrono::milliseconds{ 0 }) == 1);
+
+    // A parked consumer is woken by the push
+    auto got = std::optional<int>{};
+    std::thread consumer{ [&] { got = ilist.wait_pop_front(std::chrono::seconds{ 10 }); } };
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+    ilist.push_front(42);
+    consumer.join();
+    assert(got == 42 && ilist.empty());
+    printf("timeout and wake: pass\n");
+
+    // Two parked consumers, a push wakes one, an insertion behind the
+    // pushed element must wake the other even if the first takes the
+    // pushed element, emptying the list but for the inserted one
+    for (auto round = 0; round < 4; ++round) {
+        auto first = std::optional<int>{};
+        auto second = std::optional<int>{};
+        std::thread a{ [&] { first = ilist.wait_pop_front(std::chrono::seconds{ 10 }); } };
+        std::thread b{ [&] { second = ilist.wait_pop_front(std::chrono::seconds{ 10 }); } };
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+        start = std::chrono::steady_clock::now();
+        ilist.push_front(1);
+        if (!ilist.insert_after(ilist.cbegin(), 2)) {
+            ilist.push_front(2);    // The pushed element was taken already
+        }
+        a.join();
+        b.join();
+        assert(first && second && *first + *second == 3 && ilist.empty());
+        assert(std::chrono::steady_clock::now() - start < std::chrono::seconds{ 5 });
+    }
+    printf("insert_after() wakes parked consumers: pass\n");
+
+    constexpr auto Threads = 3;
+    constexpr auto Count = 3000;
+    auto sum = std::atomic<long>{ 0 };
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < Threads; ++i) {
+        threads.emplace_back([&] {
+            for (auto j = 0; j < Count; ) {
+                if (auto v = ilist.wait_pop_front(std::chrono::seconds{ 10 })) {
+                    sum += *v;
+                    ++j;
+                }
+            }
+        });
+    }
+    for (auto i = 0; i < Threads; ++i) {
+        threads.emplace_back([&, i] {
+            for (auto j = 0; j < Count; j += 2) {
+                if (i % 2) {
+                    int range[] = { j, j + 1 };
+                    ilist.push_front_range(range, range + 2);
+                } else {
+                    ilist.push_front(j);
+                    ilist.push_front(j + 1);
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    assert(sum == static_cast<long>(Threads) * Count * (Count - 1) / 2 && ilist.empty());
+    printf("simultaneous wait_pop_front() and pushes: pass\n");
+
+#if HUNGBIU_COROUTINES
+    sum = 0;
+    auto finished = std::atomic<int>{ 0 };
+    for (auto i = 0; i < Threads; ++i) {
+        consume(ilist, Count, sum, finished);    // Suspends on the empty list
+    }
+    assert(finished == 0);
+    threads.clear();
+    for (auto i = 0; i < Threads; ++i) {
+        threads.emplace_back([&] {
+            for (auto j = 0; j < Count; ++j) {
+                ilist.push_front(j);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    assert(finished == Threads && sum == static_cast<long>(Threads) * Count * (Count - 1) / 2 && ilist.empty());
+    printf("async_pop_front(): pass\n");
+#endif
+    epoch_reclaimer::collect();
+}
+
+template<typename Value, typename SyncPolicy>
+void test_export(const char *name)
+{
+    printf("--- export_to, %s ---\n", name);
+    typedef concurrent_forward_list<Value, epoch_reclaimer, std::allocator<Value>, SyncPolicy> list_type;
+    if constexpr (std::is_same_v<Value, int>) {
+        // The tagged link and the value, no more
+        static_assert(list_type::node_size == 2 * sizeof(void *));
+    }
+    auto value = [](int i) {
+        if constexpr (std::is_same_v<Value, int>) {
+            return i;
+        } else {
+            return std::to_string(i);
+        }
+    };
+    list_type vlist;
+    Value out[16];
+    assert(vlist.export_to(out, 16) == 0);
+    for (auto i = 0; i < 10; ++i) {
+        vlist.push_front(value(i));
+    }
+    assert(vlist.erase_after(vlist.cbegin()));  // 8
+    assert(vlist.export_to(out, 4) == 4);
+    assert(out[0] == value(9) && out[1] == value(7) && out[3] == value(5));
+    assert(vlist.export_to(out, 16) == 9 && out[8] == value(0));
+    assert(vlist.export_to(out, 0) == 0);
+    printf("export_to(): pass\n");
+
+    // Exports see a prefix of live elements while others push and pop
+    constexpr auto Count = 20000;
+    auto done = std::atomic<bool>{ false };
+    std::thread modifier{ [&] {
+        for (auto j = 0; j < Count; ++j) {
+            vlist.push_front(value(100 + j % 50));
+            vlist.pop_front();
+        }
+        done = true;
+    } };
+    while (!done) {
+        auto n = vlist.export_to(out, 16);
+        assert(n >= 9 && n <= 10);
+    }
+    modifier.join();
+    assert(vlist.export_to(out, 16) == 9 && out[0] == value(9));
+    printf("export_to() under simultaneous modifiers: pass\n");
+    epoch_reclaimer::collect();
+}
+
+template<typename Value, typename Layout>
+void test_for_each_batch(const char *name)
+{
+    printf("--- for_each_batch, %s ---\n", name);
+    typedef concurrent_forward_list<Value, epoch_reclaimer, std::allocator<Value>, locking_policy, no_stats, Layout> list_type;
+    auto value = [](int i) {
+        if constexpr (std::is_same_v<Value, int>) {
+            return i;
+        } else {
+            return std::to_string(i);
+        }
+    };
+    list_type vlist;
+    auto calls = 0;
+    vlist.for_each_batch([&calls](const Value *, size_t) { ++calls; });
+    assert(calls == 0);
+
+    // Full runs of Batch in list order, then the rest
+    constexpr auto Max = 100;
+    for (auto i = 0; i < Max; ++i) {
+        vlist.push_front(value(i));
+    }
+    auto seen = std::vector<Value>{};
+    auto sizes = std::vector<size_t>{};
+    vlist.template for_each_batch<7>([&](const Value *values, size_t n) {
+        seen.insert(seen.end(), values, values + n);
+        sizes.push_back(n);
+    });
+    assert(seen.size() == Max && sizes.size() == (Max + 6) / 7 && sizes.back() == Max % 7);
+    assert(std::all_of(sizes.begin(), sizes.end() - 1, [](size_t n) { return n == 7; }));
+    for (auto i = 0; i < Max; ++i) {
+        assert(seen[i] == value(Max - 1 - i));
+    }
+    seen.clear();
+    vlist.template for_each_batch<1>([&](const Value *values, size_t n) {
+        assert(n == 1);
+        seen.push_back(*values);
+    });
+    assert(seen.size() == Max && seen.front() == value(Max - 1));
+    calls = 0;
+    vlist.for_each_batch([&calls](const Value *, size_t n) {
+        assert(n == (calls++ ? Max - list_type::DefaultBatch : list_type::DefaultBatch));
+    });
+    assert(calls == 2);
+    printf("for_each_batch(): pass\n");
+
+    // Batches skip erased elements and see the stable ones while others
+    // push and pop
+    constexpr auto Count = 20000;
+    auto done = std::atomic<bool>{ false };
+    std::thread modifier{ [&] {
+        for (auto j = 0; j < Count; ++j) {
+            vlist.push_front(value(-1));
+            vlist.pop_front();
+        }
+        done = true;
+    } };
+    while (!done) {
+        auto stable = 0;
+        vlist.template for_each_batch<16>([&](const Value *values, size_t n) {
+            assert(n <= 16);
+            stable += static_cast<int>(std::count_if(values, values + n,
+                                                     [&](const Value &v) { return v != value(-1); }));
+        });
+        assert(stable == Max);
+    }
+    modifier.join();
+    printf("for_each_batch() under simultaneous modifiers: pass\n");
+    epoch_reclaimer::collect();
+}
+
+void test_node_pool()
+{
+    printf("--- node_pool_allocator ---\n");
+    node_pool_allocator<double> alloc{};
+    auto p = alloc.allocate(1);
+    alloc.deallocate(p, 1);
+    auto q = alloc.allocate(1);
+    assert(p == q);
+    alloc.deallocate(q, 1);
+
+    // Storage freed by another thread is recycled as well
+    double *r = nullptr;
+    std::thread t{ [&r] { r = node_pool_allocator<double>{}.allocate(1); } };
+    t.join();
+    alloc.deallocate(r, 1);
+    assert(alloc.allocate(1) == r);
+    alloc.deallocate(r, 1);
+    printf("recycle: pass\n");
+
+    // A thread-local constructed before the thread's cache is destroyed
+    // after it, and still allocates and frees
+    struct late_user
+    {
+        double *m_held = nullptr;
+        ~late_user() {
+            auto alloc = node_pool_allocator<double>{};
+            alloc.deallocate(m_held, 1);
+            alloc.deallocate(alloc.allocate(1), 1);
+        }
+    };
+    std::thread exiting{ [] {
+        thread_local late_user user;
+        user.m_held = node_pool_allocator<double>{}.allocate(1);
+    } };
+    exiting.join();
+    printf("free after the thread's cache is gone: pass\n");
+}
+
+int main()
+{
+    test_list<epoch_reclaimer>("epoch_reclaimer");
+    test_list<hazard_pointer_reclaimer>("hazard_pointer_reclaimer");
+    test_list<epoch_reclaimer, node_pool_allocator<int>>("epoch_reclaimer, node_pool_allocator");
+    test_list<hazard_pointer_reclaimer, node_pool_allocator<int>>("hazard_pointer_reclaimer, node_pool_allocator");
+    test_list<epoch_reclaimer, std::allocator<int>, lock_free_policy>("epoch_reclaimer, lock_free_policy");
+    test_list<hazard_pointer_reclaimer, std::allocator<int>, lock_free_policy>("hazard_pointer_reclaimer, lock_free_policy");
+    test_try_pop<locking_policy>("locking_policy");
+    test_try_pop<lock_free_policy>("lock_free_policy");
+    test_emplace<locking_policy>("locking_policy");
+    test_emplace<lock_free_policy>("lock_free_policy");
+    test_range<locking_policy>("locking_policy");
+    test_range<lock_free_policy>("lock_free_policy");
+    test_take_all<epoch_reclaimer, locking_policy>("epoch_reclaimer, locking_policy");
+    test_take_all<hazard_pointer_reclaimer, lock_free_policy>("hazard_pointer_reclaimer, lock_free_policy");
+    test_teardown<epoch_reclaimer>("epoch_reclaimer");
+    test_teardown<hazard_pointer_reclaimer>("hazard_pointer_reclaimer");
+    test_elimination<epoch_reclaimer, lock_free_policy>("epoch_reclaimer, lock_free_policy");
+    test_elimination<hazard_pointer_reclaimer, locking_policy>("hazard_pointer_reclaimer, locking_policy");
+    test_size<epoch_reclaimer, locking_policy>("epoch_reclaimer, locking_policy");
+    test_size<hazard_pointer_reclaimer, lock_free_policy>("hazard_pointer_reclaimer, lock_free_policy");
+    test_for_each<epoch_reclaimer, locking_policy>("epoch_reclaimer, locking_policy");
+    test_for_each<hazard_pointer_reclaimer, lock_free_policy>("hazard_pointer_reclaimer, lock_free_policy");
+    test_positional<epoch_reclaimer, locking_policy>("epoch_reclaimer, locking_policy");
+    test_positional<hazard_pointer_reclaimer, lock_free_policy>("hazard_pointer_reclaimer, lock_free_policy");
+    test_remove_if<epoch_reclaimer, locking_policy>("epoch_reclaimer, locking_policy");
+    test_remove_if<hazard_pointer_reclaimer, lock_free_policy>("hazard_pointer_reclaimer, lock_free_policy");
+    test_stats<locking_policy>("locking_policy");
+    test_stats<lock_free_policy>("lock_free_policy");
+    test_layout<locking_policy>("locking_policy");
+    test_layout<lock_free_policy>("lock_free_policy");
+    test_snapshot<locking_policy>("locking_policy");
+    test_snapshot<lock_free_policy>("lock_free_policy");
+    test_wait_pop<locking_policy>("locking_policy");
+    test_wait_pop<lock_free_policy>("lock_free_policy");
+    test_export<int, locking_policy>("int, locking_policy");
+    test_export<std::string, lock_free_policy>("std::string, lock_free_policy");
+    test_for_each_batch<int, split_layout>("int, split_layout");
+    test_for_each_batch<std::string, compact_layout>("std::string, compact_layout");
+    test_node_pool();
 }
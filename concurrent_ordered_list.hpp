@@ -0,0 +1,446 @@
+#pragma once
+#include <type_traits>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <tuple>
+#include "reclamation.hpp"
+#include "tagged_link.hpp"
+#include "list_traversal.hpp"
+
+namespace hungbiu {
+
+// A concurrent sorted singly linked list of unique keys, in the manner of
+// Harris (erase marks the link of a node, then unlinks it by CAS on its
+// predecessor) with the hazard-pointer friendly search of Michael: a
+// search unlinks and retires the marked nodes it passes, so it never steps
+// out of a node that may already be unlinked.
+//
+// insert/erase are lock-free. Lookups are wait-free with a Reclaimer that
+// covers unlinked nodes (epoch_reclaimer): they walk the links without
+// helping, and a node reached is in the list unless it is marked. With
+// hazard pointers lookups search like insert/erase, and are lock-free.
+//
+// Reclaimer and Allocator are as in concurrent_forward_list.
+template<typename Key,
+         typename T,
+         typename Compare = std::less<Key>,
+         typename Reclaimer = epoch_reclaimer,
+         typename Allocator = std::allocator<std::pair<const Key, T>>>
+class concurrent_ordered_list
+{
+public:
+    typedef Key                     key_type;
+    typedef T                       mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef Compare                 key_compare;
+    typedef Allocator               allocator_type;
+private:
+    struct list_node
+    {
+        typedef list_node*                     pointer;
+        typedef detail::tagged_link<list_node> link_t;
+
+        // Data members
+        link_t      m_link;
+        value_type  m_val;
+
+        // Constructor
+        template<typename... Args>
+        explicit list_node(Args&&... args) :
+            m_link(), m_val(std::forward<Args>(args)...) {}
+        list_node(const list_node &) = delete;
+        list_node &operator= (const list_node &) = delete;
+
+        const Key &key() const noexcept {
+            return m_val.first;
+        }
+        bool is_deleted() const noexcept {
+            return m_link.is_deleted();
+        }
+    };
+
+    typedef list_node                   node_type;
+    typedef typename list_node::pointer pointer;
+    typedef typename list_node::link_t  link_t;
+    typedef typename Reclaimer::guard   guard_t;
+    typedef typename link_t::word_t     word_t;
+    typedef detail::list_traversal<list_node, Reclaimer> traversal;
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<node_type> node_allocator;
+    typedef std::allocator_traits<node_allocator>                                       node_alloc_traits;
+    static_assert( node_alloc_traits::is_always_equal::value,
+                   "retired nodes are freed with a default-constructed allocator" );
+
+    // Where a key belongs: *m_prev links to m_cur, the first node
+    // not ordered before the key, and held m_prev_word when read.
+    // m_prev is the head or the link of a node protected by the
+    // search's guards, m_cur is protected as well.
+    struct position
+    {
+        link_t       *m_prev;
+        word_t        m_prev_word;
+        pointer       m_cur;
+    };
+    // The guards a search moves along the list
+    struct search_guards
+    {
+        guard_t m_prev;
+        guard_t m_cur;
+    };
+
+public:
+    // Modifying the mapped value through an iterator is NOT
+    // thread-safe. Like the iterators of concurrent_forward_list,
+    // an iterator holds a Reclaimer guard and must not be shared
+    // across threads.
+template<typename Type>
+class concurrent_ordered_list_iterator
+{
+    public:
+        typedef Type                          value_type;
+        typedef list_node*                    pointer;
+        typedef value_type&                   reference;
+        typedef const value_type&             const_reference;
+        typedef value_type*                   raw_pointer;
+        typedef const value_type*             const_raw_pointer;
+    private:
+        pointer m_node_ptr = nullptr;
+        guard_t m_guard;    // Protects *m_node_ptr
+    public:
+    // Constructor
+    concurrent_ordered_list_iterator() noexcept {}
+    concurrent_ordered_list_iterator(const concurrent_ordered_list_iterator &oth) :
+        m_node_ptr(oth.m_node_ptr) { protect_copy(); }
+    template<typename U,
+             typename = std::enable_if_t<std::is_same_v< Type,
+                                                         std::add_const_t<U>> >
+                                        >
+    concurrent_ordered_list_iterator(const concurrent_ordered_list_iterator<U> &oth) :
+        m_node_ptr(oth.m_node_ptr) { protect_copy(); }
+    concurrent_ordered_list_iterator(concurrent_ordered_list_iterator &&oth) noexcept :
+        m_node_ptr(std::exchange(oth.m_node_ptr, nullptr)),
+        m_guard(std::move(oth.m_guard)) {}
+    ~concurrent_ordered_list_iterator() = default;
+
+    // Assignment operator
+    concurrent_ordered_list_iterator&
+    operator= (const concurrent_ordered_list_iterator &rhs) {
+        if (this != &rhs) {
+            m_node_ptr = rhs.m_node_ptr;
+            protect_copy();
+        }
+        return *this;
+    }
+    concurrent_ordered_list_iterator&
+    operator= (concurrent_ordered_list_iterator &&rhs) noexcept {
+        if (this != &rhs) {
+            m_node_ptr = std::exchange(rhs.m_node_ptr, nullptr);
+            m_guard = std::move(rhs.m_guard);
+        }
+        return *this;
+    }
+
+    // Relationship operator
+    friend bool
+    operator==( const concurrent_ordered_list_iterator &lhs,
+                const concurrent_ordered_list_iterator &rhs) noexcept {
+        return lhs.m_node_ptr == rhs.m_node_ptr;
+    }
+    friend bool
+    operator!=( const concurrent_ordered_list_iterator &lhs,
+                const concurrent_ordered_list_iterator &rhs) noexcept {
+        return lhs.m_node_ptr != rhs.m_node_ptr;
+    }
+
+    // Test if the iterator points to an element that is present in the list
+    bool is_valid() const noexcept{
+        return m_node_ptr &&
+               !m_node_ptr->is_deleted();
+    }
+    explicit operator bool() const noexcept{
+        return is_valid();
+    }
+
+    // Dereference
+    reference operator* () const noexcept {
+        return m_node_ptr->m_val;
+    }
+    raw_pointer operator-> () const noexcept {
+        return &(m_node_ptr->m_val);
+    }
+
+    // Advance forward, in key order
+    // Pre-increment
+    concurrent_ordered_list_iterator &operator++ ()
+    {
+        m_node_ptr = traversal::advance(m_node_ptr, m_guard);
+        return *this;
+    }
+    // Post-increment
+    concurrent_ordered_list_iterator operator++ (int) {
+        auto tmp_iter = *this;
+        m_node_ptr = traversal::advance(m_node_ptr, m_guard);
+        return tmp_iter;
+    }
+
+private:
+    // Take over a node protected by g
+    concurrent_ordered_list_iterator(pointer node_ptr, guard_t &&g) noexcept :
+        m_node_ptr(node_ptr), m_guard(std::move(g)) {}
+    void protect_copy() {
+        if (m_node_ptr) {
+            m_guard.set(m_node_ptr);
+        } else {
+            m_guard.reset();
+        }
+    }
+
+    friend class concurrent_ordered_list;
+    template<typename> friend class concurrent_ordered_list_iterator;
+};
+    typedef concurrent_ordered_list_iterator<value_type>       iterator;
+    typedef concurrent_ordered_list_iterator<const value_type> const_iterator;
+
+private:
+    mutable link_t  m_head;     // Never marked, searches help to unlink
+    Compare         m_comp;
+public:
+    // Constructor
+    concurrent_ordered_list() = default;
+    explicit concurrent_ordered_list(const Compare &comp) :
+        m_comp(comp) {}
+    concurrent_ordered_list(const concurrent_ordered_list &) = delete;
+    // Not thread-safe: no other thread may access the list any more
+    ~concurrent_ordered_list() {
+        auto p = m_head.next();
+        while (p) {
+            auto next = p->m_link.next();
+            destroy_node(p);
+            p = next;
+        }
+    }
+    concurrent_ordered_list &operator= (const concurrent_ordered_list &) = delete;
+
+    // Iterators
+    // Elements are visited in key order, erased ones are skipped
+    iterator begin() {
+        auto g = guard_t{};
+        auto p = traversal::first_live(typename traversal::link_anchor{ m_head }, g);
+        return iterator{ p, std::move(g) };
+    }
+    const_iterator cbegin() const {
+        auto g = guard_t{};
+        auto p = traversal::first_live(typename traversal::link_anchor{ m_head }, g);
+        return const_iterator{ p, std::move(g) };
+    }
+    iterator end() noexcept {
+        return iterator{};
+    }
+    const_iterator cend() const noexcept {
+        return const_iterator{};
+    }
+
+    // Lookup
+    // --------------------------------------------------
+
+    bool contains(const Key &key) const {
+        if constexpr (Reclaimer::covers_unlinked_nodes) {
+            auto g = guard_t{};
+            return wait_free_find(key, g) != nullptr;
+        } else {
+            auto sg = search_guards{};
+            auto pos = position{};
+            return search(key, pos, sg);
+        }
+    }
+    // Returns an iterator to the element with key, or end()
+    iterator find(const Key &key) {
+        auto g = guard_t{};
+        auto p = find_node(key, g);
+        return iterator{ p, std::move(g) };
+    }
+    const_iterator find(const Key &key) const {
+        auto g = guard_t{};
+        auto p = find_node(key, g);
+        return const_iterator{ p, std::move(g) };
+    }
+
+    // Modifiers
+    // --------------------------------------------------
+
+    // Insert key with the mapped value, unless key is already present
+    // Returns a bool indicates if the insertion actually take place
+    bool insert(const Key &key, const T &val) {
+        return emplace(key, val);
+    }
+    bool insert(const Key &key, T &&val) {
+        return emplace(key, std::move(val));
+    }
+    // Insert key with the mapped value constructed in place from args
+    // Returns a bool indicates if the insertion actually take place
+    template<typename... Args>
+    bool emplace(const Key &key, Args&&... args) {
+        auto sg = search_guards{};
+        auto pos = position{};
+        auto new_node = pointer{};
+        for (;;) {
+            if (search(key, pos, sg)) {
+                if (new_node) {
+                    destroy_node(new_node);
+                }
+                return false;
+            }
+            // Allocate once the key is known to be missing
+            if (!new_node) {
+                new_node = create_node( std::piecewise_construct,
+                                        std::forward_as_tuple(key),
+                                        std::forward_as_tuple(std::forward<Args>(args)...) );
+            }
+            new_node->m_link.init(pos.m_cur);
+            if (pos.m_prev->compare_exchange(pos.m_prev_word, new_node)) {
+                return true;
+            }
+        }
+    }
+    // Erase the element with key
+    // Returns a bool indicates if the erasure actually take place
+    bool erase(const Key &key) {
+        auto sg = search_guards{};
+        auto pos = position{};
+        for (;;) {
+            if (!search(key, pos, sg)) {
+                return false;
+            }
+            auto cur = pos.m_cur;
+            auto w = cur->m_link.load();
+            if (link_t::is_deleted(w) || !cur->m_link.try_mark(w)) {
+                continue;   // Someone else erased it, or its successor changed
+            }
+            // Erased. Unlink it, or leave it to a search that helps.
+            if (pos.m_prev->compare_exchange(pos.m_prev_word, link_t::pointer_of(w))) {
+                retire_node(cur);
+            } else {
+                search(key, pos, sg);
+            }
+            return true;
+        }
+    }
+    // Release all elements. Like concurrent_forward_list::clear(), the
+    // detached nodes are marked so that operations on them fail.
+    void clear() {
+        auto w = m_head.load();
+        while (w && !m_head.compare_exchange(w, nullptr)) ;
+        auto p = link_t::pointer_of(w);
+        while (p) {
+            auto nw = p->m_link.load();
+            while (!link_t::is_deleted(nw) && !p->m_link.try_mark(nw)) ;
+            retire_node(p);
+            p = link_t::pointer_of(nw);
+        }
+    }
+
+    // Capacity
+    bool empty() const {
+        return cbegin() == cend();
+    }
+
+    key_compare key_comp() const {
+        return m_comp;
+    }
+    allocator_type get_allocator() const noexcept {
+        return allocator_type{};
+    }
+
+private:
+    template<typename... Args>
+    static pointer create_node(Args&&... args) {
+        auto alloc = node_allocator{};
+        auto p = node_alloc_traits::allocate(alloc, 1);
+        try {
+            node_alloc_traits::construct(alloc, p, std::forward<Args>(args)...);
+        } catch (...) {
+            node_alloc_traits::deallocate(alloc, p, 1);
+            throw;
+        }
+        return p;
+    }
+    static void destroy_node(void *p) {
+        auto alloc = node_allocator{};
+        auto node = static_cast<pointer>(p);
+        node_alloc_traits::destroy(alloc, node);
+        node_alloc_traits::deallocate(alloc, node, 1);
+    }
+    static void retire_node(pointer p) {
+        Reclaimer::retire(p, &destroy_node);
+    }
+
+    // Michael's search: find the position of key, unlinking and retiring
+    // the marked nodes on the way. Returns true if pos.m_cur holds key.
+    bool search(const Key &key, position &pos, search_guards &sg) const {
+    retry:
+        auto prev = &m_head;
+        auto w = prev->load();
+        sg.m_prev.reset();
+        for (;;) {
+            auto cur = link_t::pointer_of(w);
+            if (!cur) {
+                pos = position{ prev, w, nullptr };
+                return false;
+            }
+            sg.m_cur.set(cur);
+            if (prev->load(std::memory_order_seq_cst) != w) {
+                goto retry;     // prev got marked or relinked
+            }
+            auto cw = cur->m_link.load();
+            if (link_t::is_deleted(cw)) {
+                // Help to unlink the erased cur, its unlinker retires it
+                auto next = link_t::pointer_of(cw);
+                if (!prev->compare_exchange(w, next)) {
+                    goto retry;
+                }
+                retire_node(cur);
+                w = link_t::to_word(next);
+                continue;
+            }
+            if (!m_comp(cur->key(), key)) {
+                pos = position{ prev, w, cur };
+                return !m_comp(key, cur->key());
+            }
+            prev = &cur->m_link;
+            w = cw;
+            sg.m_prev.swap(sg.m_cur);
+        }
+    }
+    // Walk the links without helping, which needs a Reclaimer that covers
+    // unlinked nodes. Returns the node holding key, protected by g, or
+    // nullptr if key is not present.
+    pointer wait_free_find(const Key &key, guard_t &g) const {
+        g.set(&m_head);
+        auto cur = m_head.next();
+        while (cur && m_comp(cur->key(), key)) {
+            cur = cur->m_link.next();
+        }
+        if (cur && !m_comp(key, cur->key()) && !cur->is_deleted()) {
+            return cur;
+        }
+        g.reset();
+        return nullptr;
+    }
+    pointer find_node(const Key &key, guard_t &g) const {
+        if constexpr (Reclaimer::covers_unlinked_nodes) {
+            return wait_free_find(key, g);
+        } else {
+            auto sg = search_guards{};
+            auto pos = position{};
+            if (!search(key, pos, sg)) {
+                return nullptr;
+            }
+            g.swap(sg.m_cur);
+            return pos.m_cur;
+        }
+    }
+};
+
+}; // end of namespace hungbiu
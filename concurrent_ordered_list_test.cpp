@@ -0,0 +1,121 @@
+#include "concurrent_ordered_list.hpp"
+#include "node_pool.hpp"
+#include <thread>
+#include <stdio.h>
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <functional>
+
+using namespace hungbiu;
+
+template<typename list_type>
+size_t list_size(const list_type &lst) {
+    size_t sz = 0;
+    for ( auto i = lst.cbegin();
+          i != lst.cend();
+          ++i, ++sz) ;
+    return sz;
+}
+
+template< typename Reclaimer,
+          typename Allocator = std::allocator<std::pair<const int, std::string>>>
+void test_ordered_list(const char *name)
+{
+    printf("--- %s ---\n", name);
+    typedef concurrent_ordered_list<int, std::string, std::less<int>, Reclaimer, Allocator> list_type;
+    list_type colist{};
+    assert(colist.empty());
+
+    // insert
+    for (auto k : { 5, 1, 4, 2, 3 }) {
+        assert(colist.insert(k, std::to_string(k)));
+    }
+    assert(!colist.insert(3, "three"));
+    assert(colist.emplace(0, 3, 'x'));
+    auto expected = 0;
+    for (auto it = colist.cbegin(); it != colist.cend(); ++it, ++expected) {
+        assert(it->first == expected);
+        assert(it.is_valid());
+    }
+    assert(expected == 6);
+    printf("insert: pass\n");
+
+    // find and contains
+    auto it = colist.find(3);
+    assert(it != colist.end() && it->second == "3");
+    assert(colist.find(7) == colist.end());
+    assert(colist.contains(0) && colist.find(0)->second == "xxx");
+    assert(!colist.contains(-1));
+    printf("find: pass\n");
+
+    // erase
+    assert(colist.erase(3));
+    assert(!colist.erase(3));
+    assert(!it.is_valid());
+    assert(!colist.contains(3));
+    assert(list_size(colist) == 5);
+    ++it;
+    assert(!it || it->first == 4);
+    printf("erase: pass\n");
+
+    colist.clear();
+    assert(colist.empty());
+    assert(colist.insert(1, "1"));
+    printf("clear: pass\n");
+
+    // Threads insert and erase their own keys, interleaved with the
+    // others', while readers look the keys up
+    concurrent_ordered_list<int, int, std::less<int>, Reclaimer> ilist{};
+    constexpr auto Threads = 4;
+    constexpr auto PerThread = 2000;
+    std::atomic<bool> done{ false };
+    auto writer = [&ilist](int id) {
+        for (auto i = 0; i < PerThread; ++i) {
+            auto key = i * Threads + id;
+            assert(ilist.insert(key, key));
+            assert(ilist.contains(key));
+            if (i % 2) {
+                assert(ilist.erase(key));
+                assert(!ilist.contains(key));
+            }
+        }
+    };
+    auto reader = [&] {
+        while (!done.load()) {
+            auto last = -1;
+            for (auto beg = ilist.cbegin(); beg != ilist.cend(); ++beg) {
+                assert(beg->first > last);
+                last = beg->first;
+            }
+            ilist.contains(last);
+        }
+    };
+    auto threads = std::vector<std::thread>{};
+    threads.emplace_back(reader);
+    for (auto id = 0; id < Threads; ++id) {
+        threads.emplace_back(writer, id);
+    }
+    for (auto i = 1; i <= Threads; ++i) {
+        threads[i].join();
+    }
+    done.store(true);
+    threads[0].join();
+    auto count = 0;
+    for (auto beg = ilist.cbegin(); beg != ilist.cend(); ++beg, ++count) {
+        auto i = beg->first / Threads;
+        assert(i % 2 == 0 && beg->second == beg->first);
+    }
+    assert(count == Threads * PerThread / 2);
+    printf("simultaneous insert(), erase() and contains(): pass\n");
+    Reclaimer::collect();
+}
+
+int main()
+{
+    test_ordered_list<epoch_reclaimer>("epoch_reclaimer");
+    test_ordered_list<hazard_pointer_reclaimer>("hazard_pointer_reclaimer");
+    test_ordered_list<epoch_reclaimer, node_pool_allocator<std::pair<const int, std::string>>>(
+        "epoch_reclaimer, node_pool_allocator");
+}
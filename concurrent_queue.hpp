@@ -0,0 +1,215 @@
+#pragma once
+#include <type_traits>
+#include <memory>
+#include <atomic>
+#include <optional>
+#include <utility>
+#include <new>
+#include "reclamation.hpp"
+#include "cache_line.hpp"
+
+namespace hungbiu {
+
+// An unbounded multi-producer multi-consumer FIFO queue (Michael & Scott,
+// 1996): a singly linked list from m_head to m_tail, where the head node
+// is a dummy whose successor holds the front element. push links a node
+// after the tail and then swings m_tail, pop swings m_head to the
+// successor, which becomes the new dummy; either helps to swing a lagging
+// m_tail first. Producers and consumers only meet on an empty queue.
+//
+// push/pop are lock-free. Reclaimer and Allocator are as in
+// concurrent_forward_list: the old dummy is retired when m_head leaves
+// it, and node_pool_allocator serves the nodes.
+template<typename T,
+         typename Reclaimer = epoch_reclaimer,
+         typename Allocator = std::allocator<T>>
+class concurrent_queue
+{
+public:
+    typedef T           value_type;
+    typedef Allocator   allocator_type;
+private:
+    // The element is constructed in place by push, and destroyed by the
+    // pop that takes it, when its node becomes the dummy
+    struct queue_node
+    {
+        typedef queue_node* pointer;
+
+        // Data members
+        std::atomic<pointer>     m_next;
+        alignas(T) unsigned char m_storage[sizeof(T)];
+
+        // Constructor
+        queue_node() noexcept :
+            m_next(nullptr) {}
+        queue_node(const queue_node &) = delete;
+        queue_node &operator= (const queue_node &) = delete;
+
+        T *value() noexcept {
+            return std::launder(reinterpret_cast<T *>(m_storage));
+        }
+    };
+    static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_destructible_v<T>,
+                  "concurrent_queue requires elements that move and destroy without throwing");
+
+    typedef queue_node                   node_type;
+    typedef typename queue_node::pointer pointer;
+    typedef typename Reclaimer::guard    guard_t;
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<node_type> node_allocator;
+    typedef std::allocator_traits<node_allocator>                                       node_alloc_traits;
+    static_assert( node_alloc_traits::is_always_equal::value,
+                   "retired nodes are freed with a default-constructed allocator" );
+
+    // Data members
+    // Consumers and producers CAS on separate cache lines
+    alignas(detail::cache_line_size) std::atomic<pointer> m_head;
+    alignas(detail::cache_line_size) std::atomic<pointer> m_tail;
+
+public:
+    // Constructor
+    concurrent_queue() :
+        m_head(nullptr), m_tail(nullptr)
+    {
+        auto dummy = create_node();
+        m_head.store(dummy, std::memory_order_relaxed);
+        m_tail.store(dummy, std::memory_order_relaxed);
+    }
+    concurrent_queue(const concurrent_queue &) = delete;
+    concurrent_queue &operator= (const concurrent_queue &) = delete;
+
+    // Destructor: not thread-safe
+    ~concurrent_queue() {
+        auto p = m_head.load(std::memory_order_relaxed);
+        auto next = p->m_next.load(std::memory_order_relaxed);
+        destroy_node(p);
+        for (p = next; p; p = next) {
+            next = p->m_next.load(std::memory_order_relaxed);
+            p->value()->~T();
+            destroy_node(p);
+        }
+    }
+
+    // Modifiers
+    void push(const T &val) {
+        emplace(val);
+    }
+    void push(T &&val) {
+        emplace(std::move(val));
+    }
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        auto node = create_node();
+        try {
+            ::new (static_cast<void *>(node->m_storage)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            destroy_node(node);
+            throw;
+        }
+        link_at_tail(node);
+    }
+
+    std::optional<T> try_pop() {
+        auto gh = guard_t{};
+        auto gn = guard_t{};
+        auto p = unlink_front(gh, gn);
+        if (!p) {
+            return std::nullopt;
+        }
+        auto v = p->value();
+        auto ret = std::optional<T>{ std::move(*v) };
+        v->~T();
+        return ret;
+    }
+    // Returns a bool indicates if a value was moved into out
+    bool try_pop(T &out) {
+        auto gh = guard_t{};
+        auto gn = guard_t{};
+        auto p = unlink_front(gh, gn);
+        if (!p) {
+            return false;
+        }
+        auto v = p->value();
+        auto val = T(std::move(*v));
+        v->~T();
+        out = std::move(val);
+        return true;
+    }
+
+    // Capacity
+    bool empty() const {
+        auto g = guard_t{};
+        auto h = g.protect(m_head);
+        return !h->m_next.load(std::memory_order_acquire);
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return allocator_type{};
+    }
+
+private:
+    static pointer create_node() {
+        auto alloc = node_allocator{};
+        auto p = node_alloc_traits::allocate(alloc, 1);
+        node_alloc_traits::construct(alloc, p);
+        return p;
+    }
+    // Frees the node only, its element is destroyed by the pop taking it
+    static void destroy_node(void *p) {
+        auto alloc = node_allocator{};
+        auto node = static_cast<pointer>(p);
+        node_alloc_traits::destroy(alloc, node);
+        node_alloc_traits::deallocate(alloc, node, 1);
+    }
+
+    // The tail node is only retired once popped past, which m_head cannot
+    // do before m_tail has moved on, so a validated tail stays alive
+    void link_at_tail(pointer node) {
+        auto g = guard_t{};
+        for (;;) {
+            auto t = g.protect(m_tail);
+            auto next = t->m_next.load(std::memory_order_acquire);
+            if (next) {
+                // Help the producer that linked next
+                m_tail.compare_exchange_weak(t, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            if (t->m_next.compare_exchange_weak(next, node, std::memory_order_release, std::memory_order_relaxed)) {
+                m_tail.compare_exchange_strong(t, node, std::memory_order_release, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    // Swing m_head to its successor and retire the old dummy. Returns the
+    // new dummy, protected by gn, whose element the caller then owns;
+    // nullptr if the queue is empty.
+    pointer unlink_front(guard_t &gh, guard_t &gn) {
+        for (;;) {
+            auto h = gh.protect(m_head);
+            auto next = h->m_next.load(std::memory_order_acquire);
+            if (!next) {
+                // m_head never moves past a node without successor, so h
+                // was still the head, and the queue empty, at this point
+                return nullptr;
+            }
+            gn.set(next);
+            if (m_head.load(std::memory_order_seq_cst) != h) {
+                continue;       // next may be retired already
+            }
+            auto t = m_tail.load(std::memory_order_acquire);
+            if (t == h) {
+                // Keep m_tail from falling behind m_head
+                m_tail.compare_exchange_strong(t, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            if (m_head.compare_exchange_strong(h, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                gh.reset();
+                Reclaimer::retire(h, &destroy_node);
+                return next;
+            }
+        }
+    }
+};
+
+}; // end of namespace hungbiu
@@ -0,0 +1,96 @@
+#include "concurrent_queue.hpp"
+#include "node_pool.hpp"
+#include <thread>
+#include <stdio.h>
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <vector>
+
+using namespace hungbiu;
+
+template< typename Reclaimer,
+          typename Allocator = std::allocator<std::string>>
+void test_queue(const char *name)
+{
+    printf("--- %s ---\n", name);
+    concurrent_queue<std::string, Reclaimer, Allocator> q{};
+    assert(q.empty() && !q.try_pop());
+
+    // FIFO order
+    for (auto i = 0; i < 100; ++i) {
+        q.push(std::to_string(i));
+    }
+    q.emplace(3, 'x');
+    assert(!q.empty());
+    auto s = std::string{};
+    for (auto i = 0; i < 100; ++i) {
+        if (i % 2) {
+            auto v = q.try_pop();
+            assert(v && *v == std::to_string(i));
+        } else {
+            assert(q.try_pop(s) && s == std::to_string(i));
+        }
+    }
+    assert(q.try_pop(s) && s == "xxx");
+    assert(q.empty() && !q.try_pop(s) && s == "xxx");
+    printf("push(), try_pop(): pass\n");
+
+    // The destructor destroys what is left
+    {
+        concurrent_queue<std::string, Reclaimer, Allocator> lq{};
+        lq.push(std::string(100, 'a'));
+        lq.push(std::string(100, 'b'));
+        assert(*lq.try_pop() == std::string(100, 'a'));
+    }
+    printf("destructor: pass\n");
+
+    // Every value pushed is popped exactly once, and each producer's
+    // values come out in the order it pushed them
+    constexpr auto Producers = 3;
+    constexpr auto Consumers = 3;
+    constexpr auto PerProducer = 50000;
+    concurrent_queue<long, Reclaimer> iq{};
+    std::atomic<long> sum{ 0 };
+    std::atomic<int> popped{ 0 };
+    auto producer = [&iq](int id) {
+        for (auto i = 0; i < PerProducer; ++i) {
+            iq.push(static_cast<long>(i) * Producers + id);
+        }
+    };
+    auto consumer = [&] {
+        auto last = std::vector<long>(Producers, -1);
+        while (popped.load() < Producers * PerProducer) {
+            auto v = long{};
+            if (iq.try_pop(v)) {
+                auto id = v % Producers;
+                assert(v / Producers > last[id]);
+                last[id] = v / Producers;
+                sum += v;
+                ++popped;
+            }
+        }
+    };
+    auto threads = std::vector<std::thread>{};
+    for (auto id = 0; id < Producers; ++id) {
+        threads.emplace_back(producer, id);
+    }
+    for (auto i = 0; i < Consumers; ++i) {
+        threads.emplace_back(consumer);
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    const long total = static_cast<long>(Producers) * PerProducer;
+    assert(popped.load() == total && iq.empty());
+    assert(sum.load() == total * (total - 1) / 2);
+    printf("simultaneous producers and consumers: pass\n");
+    Reclaimer::collect();
+}
+
+int main()
+{
+    test_queue<epoch_reclaimer>("epoch_reclaimer");
+    test_queue<hazard_pointer_reclaimer>("hazard_pointer_reclaimer");
+    test_queue<epoch_reclaimer, node_pool_allocator<std::string>>("epoch_reclaimer, node_pool_allocator");
+}
@@ -0,0 +1,634 @@
+#pragma once
+#include <type_traits>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <tuple>
+#include <new>
+#include <cstdint>
+#include "reclamation.hpp"
+#include "tagged_link.hpp"
+#include "list_traversal.hpp"
+
+namespace hungbiu {
+
+// A lock-free skip list of unique keys (Fraser; Herlihy and Shavit). Every
+// level is a Harris list: erase marks the links of a node top-down, the mark
+// on level 0 deciding who erased it, and searches unlink the marked nodes
+// they pass on each level. find/insert/erase take O(log n) expected steps.
+//
+// An erased node may still be linked into upper levels by its inserter, so
+// it is retired only once both are done with it: the later of the two
+// unlinks it from every level first.
+//
+// Iterators walk level 0 in key order and skip erased elements. Advancing
+// from an element erased meanwhile resumes at the next greater key, so a
+// range scan [lower_bound(lo), key > hi) keeps going under concurrent
+// updates; it sees every element present throughout the scan, and may or
+// may not see the ones inserted or erased during it.
+//
+// Lookups are wait-free with a Reclaimer that covers unlinked nodes
+// (epoch_reclaimer); with hazard pointers they search like insert/erase,
+// holding up to two hazard slots per level.
+//
+// Reclaimer and Allocator are as in concurrent_forward_list.
+template<typename Key,
+         typename T,
+         typename Compare = std::less<Key>,
+         typename Reclaimer = epoch_reclaimer,
+         typename Allocator = std::allocator<std::pair<const Key, T>>>
+class concurrent_skip_list
+{
+public:
+    typedef Key                     key_type;
+    typedef T                       mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef Compare                 key_compare;
+    typedef Allocator               allocator_type;
+
+    static constexpr unsigned MaxHeight = 24;
+private:
+    struct list_node
+    {
+        typedef list_node*                     pointer;
+        typedef detail::tagged_link<list_node> link_t;
+
+        // m_state bits, see erase()
+        static constexpr unsigned Built  = 1;
+        static constexpr unsigned Erased = 2;
+
+        // Data members
+        link_t                  m_link;         // Level 0
+        link_t                 *m_upper;        // Levels 1 .. m_height - 1
+        unsigned                m_height;
+        std::atomic<unsigned>   m_state{ 0 };
+        value_type              m_val;
+
+        // Constructor
+        template<typename... Args>
+        explicit list_node(unsigned height, Args&&... args) :
+            m_link(), m_upper(nullptr), m_height(height), m_val(std::forward<Args>(args)...) {}
+        list_node(const list_node &) = delete;
+        list_node &operator= (const list_node &) = delete;
+
+        link_t &link(unsigned level) noexcept {
+            return level ? m_upper[level - 1] : m_link;
+        }
+        const Key &key() const noexcept {
+            return m_val.first;
+        }
+        // Erased once level 0 is marked
+        bool is_deleted() const noexcept {
+            return m_link.is_deleted();
+        }
+    };
+
+    typedef list_node                   node_type;
+    typedef typename list_node::pointer pointer;
+    typedef typename list_node::link_t  link_t;
+    typedef typename Reclaimer::guard   guard_t;
+    typedef typename link_t::word_t     word_t;
+    typedef detail::list_traversal<list_node, Reclaimer> traversal;
+
+    typedef std::allocator_traits<Allocator>                                         alloc_traits;
+    typedef typename alloc_traits::template rebind_alloc<node_type>                  node_allocator;
+    typedef std::allocator_traits<node_allocator>                                    node_alloc_traits;
+    typedef typename alloc_traits::template rebind_alloc<link_t>                     tower_allocator;
+    typedef std::allocator_traits<tower_allocator>                                   tower_alloc_traits;
+    static_assert( node_alloc_traits::is_always_equal::value,
+                   "retired nodes are freed with a default-constructed allocator" );
+
+    // Where a key belongs on every level: *m_preds[i] links to m_succs[i],
+    // the first node on level i not ordered before the key, and held
+    // m_words[i] when read
+    struct position
+    {
+        link_t  *m_preds[MaxHeight];
+        word_t   m_words[MaxHeight];
+        pointer  m_succs[MaxHeight];
+    };
+    // The guards a search moves down the list. The predecessors and
+    // successors of all levels stay protected until the next search.
+    // A Reclaimer covering unlinked nodes only needs one of them.
+    struct search_guards
+    {
+        guard_t m_preds[MaxHeight];
+        guard_t m_succs[MaxHeight];
+
+        guard_t &succ(unsigned level) noexcept {
+            return m_succs[Reclaimer::covers_unlinked_nodes ? 0 : level];
+        }
+        // Protect the predecessor carried down from the level above,
+        // where it is protected already
+        void carry_pred(unsigned level, pointer pred) {
+            if constexpr (!Reclaimer::covers_unlinked_nodes) {
+                if (pred) {
+                    m_preds[level].set(pred);
+                } else {
+                    m_preds[level].reset();
+                }
+            }
+        }
+        // The successor on level becomes the predecessor
+        void step(unsigned level) noexcept {
+            if constexpr (!Reclaimer::covers_unlinked_nodes) {
+                m_preds[level].swap(m_succs[level]);
+            }
+        }
+    };
+
+public:
+    // Modifying the mapped value through an iterator is NOT thread-safe,
+    // and an iterator must not be shared across threads.
+template<typename Type>
+class concurrent_skip_list_iterator
+{
+    public:
+        typedef Type                          value_type;
+        typedef list_node*                    pointer;
+        typedef value_type&                   reference;
+        typedef value_type*                   raw_pointer;
+    private:
+        const concurrent_skip_list *m_list = nullptr;
+        pointer                     m_node_ptr = nullptr;
+        guard_t                     m_guard;    // Protects *m_node_ptr
+    public:
+    // Constructor
+    concurrent_skip_list_iterator() noexcept {}
+    concurrent_skip_list_iterator(const concurrent_skip_list_iterator &oth) :
+        m_list(oth.m_list), m_node_ptr(oth.m_node_ptr) { protect_copy(); }
+    template<typename U,
+             typename = std::enable_if_t<std::is_same_v< Type,
+                                                         std::add_const_t<U>> >
+                                        >
+    concurrent_skip_list_iterator(const concurrent_skip_list_iterator<U> &oth) :
+        m_list(oth.m_list), m_node_ptr(oth.m_node_ptr) { protect_copy(); }
+    concurrent_skip_list_iterator(concurrent_skip_list_iterator &&oth) noexcept :
+        m_list(oth.m_list),
+        m_node_ptr(std::exchange(oth.m_node_ptr, nullptr)),
+        m_guard(std::move(oth.m_guard)) {}
+    ~concurrent_skip_list_iterator() = default;
+
+    // Assignment operator
+    concurrent_skip_list_iterator&
+    operator= (const concurrent_skip_list_iterator &rhs) {
+        if (this != &rhs) {
+            m_list = rhs.m_list;
+            m_node_ptr = rhs.m_node_ptr;
+            protect_copy();
+        }
+        return *this;
+    }
+    concurrent_skip_list_iterator&
+    operator= (concurrent_skip_list_iterator &&rhs) noexcept {
+        if (this != &rhs) {
+            m_list = rhs.m_list;
+            m_node_ptr = std::exchange(rhs.m_node_ptr, nullptr);
+            m_guard = std::move(rhs.m_guard);
+        }
+        return *this;
+    }
+
+    // Relationship operator
+    friend bool
+    operator==( const concurrent_skip_list_iterator &lhs,
+                const concurrent_skip_list_iterator &rhs) noexcept {
+        return lhs.m_node_ptr == rhs.m_node_ptr;
+    }
+    friend bool
+    operator!=( const concurrent_skip_list_iterator &lhs,
+                const concurrent_skip_list_iterator &rhs) noexcept {
+        return lhs.m_node_ptr != rhs.m_node_ptr;
+    }
+
+    // Test if the iterator points to an element that is present in the list
+    bool is_valid() const noexcept{
+        return m_node_ptr &&
+               !m_node_ptr->is_deleted();
+    }
+    explicit operator bool() const noexcept{
+        return is_valid();
+    }
+
+    // Dereference
+    reference operator* () const noexcept {
+        return m_node_ptr->m_val;
+    }
+    raw_pointer operator-> () const noexcept {
+        return &(m_node_ptr->m_val);
+    }
+
+    // Advance to the next greater key
+    // Pre-increment
+    concurrent_skip_list_iterator &operator++ ()
+    {
+        m_node_ptr = m_list->step(m_node_ptr, m_guard);
+        return *this;
+    }
+    // Post-increment
+    concurrent_skip_list_iterator operator++ (int) {
+        auto tmp_iter = *this;
+        m_node_ptr = m_list->step(m_node_ptr, m_guard);
+        return tmp_iter;
+    }
+
+private:
+    // Take over a node protected by g
+    concurrent_skip_list_iterator(const concurrent_skip_list *list, pointer node_ptr, guard_t &&g) noexcept :
+        m_list(list), m_node_ptr(node_ptr), m_guard(std::move(g)) {}
+    void protect_copy() {
+        if (m_node_ptr) {
+            m_guard.set(m_node_ptr);
+        } else {
+            m_guard.reset();
+        }
+    }
+
+    friend class concurrent_skip_list;
+    template<typename> friend class concurrent_skip_list_iterator;
+};
+    typedef concurrent_skip_list_iterator<value_type>       iterator;
+    typedef concurrent_skip_list_iterator<const value_type> const_iterator;
+
+private:
+    mutable link_t      m_head[MaxHeight];  // Never marked
+    std::atomic<size_t> m_size{ 0 };
+    Compare             m_comp;
+public:
+    // Constructor
+    concurrent_skip_list() = default;
+    explicit concurrent_skip_list(const Compare &comp) :
+        m_comp(comp) {}
+    concurrent_skip_list(const concurrent_skip_list &) = delete;
+    // Not thread-safe: no other thread may access the list any more
+    ~concurrent_skip_list() {
+        auto p = m_head[0].next();
+        while (p) {
+            auto next = p->m_link.next();
+            destroy_node(p);
+            p = next;
+        }
+    }
+    concurrent_skip_list &operator= (const concurrent_skip_list &) = delete;
+
+    // Iterators
+    // Elements are visited in key order, erased ones are skipped
+    iterator begin() {
+        auto g = guard_t{};
+        auto p = traversal::first_live(typename traversal::link_anchor{ m_head[0] }, g);
+        return iterator{ this, p, std::move(g) };
+    }
+    const_iterator cbegin() const {
+        auto g = guard_t{};
+        auto p = traversal::first_live(typename traversal::link_anchor{ m_head[0] }, g);
+        return const_iterator{ this, p, std::move(g) };
+    }
+    iterator end() noexcept {
+        return iterator{};
+    }
+    const_iterator cend() const noexcept {
+        return const_iterator{};
+    }
+    // The first element with a key not ordered before key
+    iterator lower_bound(const Key &key) {
+        auto g = guard_t{};
+        auto p = seek(key, false, g);
+        return iterator{ this, p, std::move(g) };
+    }
+    const_iterator lower_bound(const Key &key) const {
+        auto g = guard_t{};
+        auto p = seek(key, false, g);
+        return const_iterator{ this, p, std::move(g) };
+    }
+    // The first element with a key ordered after key
+    iterator upper_bound(const Key &key) {
+        auto g = guard_t{};
+        auto p = seek(key, true, g);
+        return iterator{ this, p, std::move(g) };
+    }
+    const_iterator upper_bound(const Key &key) const {
+        auto g = guard_t{};
+        auto p = seek(key, true, g);
+        return const_iterator{ this, p, std::move(g) };
+    }
+
+    // Lookup
+    // --------------------------------------------------
+
+    bool contains(const Key &key) const {
+        auto g = guard_t{};
+        return find_node(key, g) != nullptr;
+    }
+    // Returns an iterator to the element with key, or end()
+    iterator find(const Key &key) {
+        auto g = guard_t{};
+        auto p = find_node(key, g);
+        return iterator{ this, p, std::move(g) };
+    }
+    const_iterator find(const Key &key) const {
+        auto g = guard_t{};
+        auto p = find_node(key, g);
+        return const_iterator{ this, p, std::move(g) };
+    }
+
+    // Modifiers
+    // --------------------------------------------------
+
+    // Insert key with the mapped value, unless key is already present
+    // Returns a bool indicates if the insertion actually take place
+    bool insert(const Key &key, const T &val) {
+        return emplace(key, val);
+    }
+    bool insert(const Key &key, T &&val) {
+        return emplace(key, std::move(val));
+    }
+    // Insert key with the mapped value constructed in place from args
+    // Returns a bool indicates if the insertion actually take place
+    template<typename... Args>
+    bool emplace(const Key &key, Args&&... args) {
+        auto sg = search_guards{};
+        auto pos = position{};
+        auto new_node = pointer{};
+        for (;;) {
+            if (search(key, false, pos, sg)) {
+                if (new_node) {
+                    destroy_node(new_node);
+                }
+                return false;
+            }
+            // Allocate once the key is known to be missing
+            if (!new_node) {
+                new_node = create_node( random_height(),
+                                        std::piecewise_construct,
+                                        std::forward_as_tuple(key),
+                                        std::forward_as_tuple(std::forward<Args>(args)...) );
+            }
+            for (auto level = 0u; level < new_node->m_height; ++level) {
+                new_node->link(level).init(pos.m_succs[level]);
+            }
+            // Present once linked on level 0
+            if (pos.m_preds[0]->compare_exchange(pos.m_words[0], new_node)) {
+                break;
+            }
+        }
+        m_size.fetch_add(1, std::memory_order_relaxed);
+        build_tower(new_node, pos, sg);
+        return true;
+    }
+    // Erase the element with key
+    // Returns a bool indicates if the erasure actually take place
+    bool erase(const Key &key) {
+        auto sg = search_guards{};
+        auto pos = position{};
+        for (;;) {
+            if (!search(key, false, pos, sg)) {
+                return false;
+            }
+            auto node = pos.m_succs[0];
+            // Freeze the upper levels, so the inserter stops building
+            for (auto level = node->m_height - 1; level > 0; --level) {
+                auto &link = node->link(level);
+                auto w = link.load();
+                while (!link_t::is_deleted(w) && !link.try_mark(w)) ;
+            }
+            auto w = node->m_link.load();
+            while (!link_t::is_deleted(w)) {
+                if (node->m_link.try_mark(w)) {
+                    // Erased by us. The inserter may still be linking the
+                    // tower; whoever of us comes second unlinks and retires.
+                    m_size.fetch_sub(1, std::memory_order_relaxed);
+                    if (node->m_state.fetch_or(list_node::Erased) & list_node::Built) {
+                        unlink_and_retire(node, sg);
+                    }
+                    return true;
+                }
+            }
+            // Someone else erased it first, search again
+        }
+    }
+
+    // Capacity
+    // The count of elements, exact only while the list is not modified
+    size_t size() const noexcept {
+        return m_size.load(std::memory_order_relaxed);
+    }
+    bool empty() const noexcept {
+        return !size();
+    }
+
+    key_compare key_comp() const {
+        return m_comp;
+    }
+    allocator_type get_allocator() const noexcept {
+        return allocator_type{};
+    }
+
+private:
+    template<typename... Args>
+    static pointer create_node(unsigned height, Args&&... args) {
+        auto alloc = node_allocator{};
+        auto p = node_alloc_traits::allocate(alloc, 1);
+        try {
+            node_alloc_traits::construct(alloc, p, height, std::forward<Args>(args)...);
+        } catch (...) {
+            node_alloc_traits::deallocate(alloc, p, 1);
+            throw;
+        }
+        if (height > 1) {
+            auto tower = tower_allocator{};
+            try {
+                p->m_upper = tower_alloc_traits::allocate(tower, height - 1);
+            } catch (...) {
+                node_alloc_traits::destroy(alloc, p);
+                node_alloc_traits::deallocate(alloc, p, 1);
+                throw;
+            }
+            for (auto level = 1u; level < height; ++level) {
+                ::new (static_cast<void *>(p->m_upper + level - 1)) link_t{};
+            }
+        }
+        return p;
+    }
+    static void destroy_node(void *p) {
+        auto alloc = node_allocator{};
+        auto node = static_cast<pointer>(p);
+        if (node->m_upper) {
+            auto tower = tower_allocator{};
+            tower_alloc_traits::deallocate(tower, node->m_upper, node->m_height - 1);
+        }
+        node_alloc_traits::destroy(alloc, node);
+        node_alloc_traits::deallocate(alloc, node, 1);
+    }
+    // Geometric with p = 1/2
+    static unsigned random_height() noexcept {
+        thread_local uint64_t state = 0x9e3779b97f4a7c15ull ^ reinterpret_cast<uintptr_t>(&state);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return 1 + static_cast<unsigned>(__builtin_ctzll(state | (uint64_t{ 1 } << (MaxHeight - 1))));
+    }
+
+    link_t *link_of(pointer pred, unsigned level) const noexcept {
+        return pred ? &pred->link(level) : &m_head[level];
+    }
+    bool stops_at(pointer cur, const Key &key, bool past_equal) const {
+        return past_equal ? m_comp(key, cur->key()) : !m_comp(cur->key(), key);
+    }
+
+    // Link node into the levels above 0, until its tower is complete or
+    // it gets erased. pos holds the search that linked it on level 0.
+    void build_tower(pointer node, position &pos, search_guards &sg) {
+        auto &key = node->key();
+        for (auto level = 1u; level < node->m_height; ++level) {
+            for (;;) {
+                // Aim the node's own link at the successor first, which
+                // fails once erase() froze it
+                auto &link = node->link(level);
+                auto w = link.load();
+                if (link_t::is_deleted(w)) {
+                    goto done;
+                }
+                if ( link_t::pointer_of(w) != pos.m_succs[level] &&
+                     !link.compare_exchange(w, pos.m_succs[level]) ) {
+                    goto done;
+                }
+                if (pos.m_preds[level]->compare_exchange(pos.m_words[level], node)) {
+                    break;
+                }
+                // The neighbourhood changed, search again
+                search(key, false, pos, sg);
+                if (node->is_deleted()) {
+                    goto done;
+                }
+            }
+        }
+    done:
+        if (node->m_state.fetch_or(list_node::Built) & list_node::Erased) {
+            unlink_and_retire(node, sg);
+        }
+    }
+    // Unlink the erased node from every level it may still be linked on,
+    // then retire it. Its inserter and eraser are both done with it.
+    void unlink_and_retire(pointer node, search_guards &sg) {
+        auto pos = position{};
+        search(node->key(), true, pos, sg);
+        Reclaimer::retire(node, &destroy_node);
+    }
+
+    // Search
+    // --------------------------------------------------
+
+    // Find the position of key on every level, unlinking the marked nodes
+    // on the way. The search stops at the first node not ordered before
+    // key, or with past_equal at the first one ordered after key, so that
+    // nodes equal to key are passed and unlinked if marked.
+    // Returns true if pos.m_succs[0] holds key (only without past_equal).
+    bool search(const Key &key, bool past_equal, position &pos, search_guards &sg) const {
+    retry:
+        auto pred = pointer{};
+        for (auto level = MaxHeight; level-- > 0; ) {
+            sg.carry_pred(level, pred);
+            auto prev = link_of(pred, level);
+            auto w = prev->load();
+            if (link_t::is_deleted(w)) {
+                goto retry;     // pred got erased
+            }
+            auto cur = pointer{};
+            for (;;) {
+                cur = link_t::pointer_of(w);
+                if (!cur) {
+                    break;
+                }
+                sg.succ(level).set(cur);
+                if constexpr (!Reclaimer::covers_unlinked_nodes) {
+                    if (prev->load(std::memory_order_seq_cst) != w) {
+                        goto retry;     // prev got marked or relinked
+                    }
+                }
+                auto cw = cur->link(level).load();
+                if (link_t::is_deleted(cw)) {
+                    // Unlink the erased cur from this level
+                    auto next = link_t::pointer_of(cw);
+                    if (!prev->compare_exchange(w, next)) {
+                        goto retry;
+                    }
+                    w = link_t::to_word(next);
+                    continue;
+                }
+                if (stops_at(cur, key, past_equal)) {
+                    break;
+                }
+                pred = cur;
+                prev = &cur->link(level);
+                w = cw;
+                sg.step(level);
+            }
+            pos.m_preds[level] = prev;
+            pos.m_words[level] = w;
+            pos.m_succs[level] = cur;
+        }
+        auto found = pos.m_succs[0];
+        return !past_equal && found && !m_comp(key, found->key());
+    }
+    // Walk down the levels without helping, which needs a Reclaimer that
+    // covers unlinked nodes. Returns the element with key, protected by g,
+    // or nullptr.
+    pointer wait_free_find(const Key &key, guard_t &g) const {
+        g.set(&m_head[0]);
+        auto pred = pointer{};
+        auto cur = pointer{};
+        for (auto level = MaxHeight; level-- > 0; ) {
+            cur = link_of(pred, level)->next();
+            while (cur && m_comp(cur->key(), key)) {
+                pred = cur;
+                cur = cur->link(level).next();
+            }
+        }
+        if (cur && !m_comp(key, cur->key()) && !cur->is_deleted()) {
+            return cur;
+        }
+        g.reset();
+        return nullptr;
+    }
+    pointer find_node(const Key &key, guard_t &g) const {
+        if constexpr (Reclaimer::covers_unlinked_nodes) {
+            return wait_free_find(key, g);
+        } else {
+            auto sg = search_guards{};
+            auto pos = position{};
+            if (!search(key, false, pos, sg)) {
+                return nullptr;
+            }
+            g.swap(sg.succ(0));
+            return pos.m_succs[0];
+        }
+    }
+    // The first element not ordered before key, or with strict the first
+    // one ordered after key, protected by g
+    pointer seek(const Key &key, bool strict, guard_t &g) const {
+        auto sg = search_guards{};
+        auto pos = position{};
+        search(key, strict, pos, sg);
+        if (!pos.m_succs[0]) {
+            g.reset();
+            return nullptr;
+        }
+        g.swap(sg.succ(0));
+        return pos.m_succs[0];
+    }
+    // Step from the protected element cur to the next one on level 0.
+    // If cur got erased its links can't be trusted with every Reclaimer,
+    // so the walk resumes from a search for the next greater key.
+    pointer step(pointer cur, guard_t &g) const {
+        auto keep = guard_t{};
+        keep.set(cur);      // Protected by g already
+        auto p = traversal::advance(cur, g);
+        if (!p && cur->is_deleted()) {
+            p = seek(cur->key(), true, g);
+        }
+        return p;
+    }
+};
+
+}; // end of namespace hungbiu
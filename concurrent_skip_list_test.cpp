@@ -0,0 +1,143 @@
+#include "concurrent_skip_list.hpp"
+#include "node_pool.hpp"
+#include <thread>
+#include <stdio.h>
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <vector>
+
+using namespace hungbiu;
+
+template< typename Reclaimer,
+          typename Allocator = std::allocator<std::pair<const int, std::string>>>
+void test_skip_list(const char *name)
+{
+    printf("--- %s ---\n", name);
+    typedef concurrent_skip_list<int, std::string, std::less<int>, Reclaimer, Allocator> list_type;
+    list_type slist{};
+    assert(slist.empty());
+
+    // insert, in a scrambled order
+    constexpr auto Max = 1000;
+    for (auto i = 0; i < Max; ++i) {
+        auto k = (i * 7919) % Max;
+        assert(slist.insert(k, std::to_string(k)));
+    }
+    assert(!slist.insert(7, "seven"));
+    assert(slist.size() == Max);
+    auto expected = 0;
+    for (auto it = slist.cbegin(); it != slist.cend(); ++it, ++expected) {
+        assert(it->first == expected && it->second == std::to_string(expected));
+    }
+    assert(expected == Max);
+    printf("insert: pass\n");
+
+    // find, contains and bounds
+    for (auto k = 0; k < Max; ++k) {
+        assert(slist.contains(k) && slist.find(k)->second == std::to_string(k));
+    }
+    assert(!slist.contains(Max) && slist.find(-1) == slist.end());
+    assert(slist.lower_bound(10)->first == 10);
+    assert(slist.upper_bound(10)->first == 11);
+    assert(slist.lower_bound(Max) == slist.end());
+    printf("find: pass\n");
+
+    // erase
+    auto it = slist.find(10);
+    for (auto k = 0; k < Max; k += 2) {
+        assert(slist.erase(k));
+    }
+    assert(!slist.erase(0));
+    assert(!it.is_valid());
+    ++it;       // Resumes at the next greater key
+    assert(it != slist.end() && it->first == 11);
+    assert(slist.lower_bound(10)->first == 11);
+    assert(slist.size() == Max / 2);
+    expected = 1;
+    for (auto beg = slist.cbegin(); beg != slist.cend(); ++beg, expected += 2) {
+        assert(beg->first == expected);
+    }
+    printf("erase: pass\n");
+
+    // Threads insert and erase their own keys, interleaved with the
+    // others', while readers scan ranges
+    concurrent_skip_list<int, int, std::less<int>, Reclaimer> ilist{};
+    constexpr auto Threads = 4;
+    constexpr auto PerThread = 5000;
+    constexpr auto Stable = 100;    // Keys [-Stable, 0) stay throughout
+    for (auto k = -Stable; k < 0; ++k) {
+        ilist.insert(k, k);
+    }
+    std::atomic<bool> done{ false };
+    auto writer = [&ilist](int id) {
+        for (auto i = 0; i < PerThread; ++i) {
+            auto key = i * Threads + id;
+            assert(ilist.insert(key, key));
+            assert(ilist.contains(key));
+            if (i % 2) {
+                assert(ilist.erase(key));
+                assert(!ilist.contains(key));
+            }
+        }
+    };
+    auto reader = [&] {
+        while (!done.load()) {
+            auto last = -Stable - 1;
+            auto stable = 0;
+            for (auto beg = ilist.lower_bound(-Stable); beg != ilist.cend() && beg->first < Stable; ++beg) {
+                assert(beg->first > last && beg->second == beg->first);
+                last = beg->first;
+                stable += beg->first < 0;
+            }
+            assert(stable == Stable);
+        }
+    };
+    auto threads = std::vector<std::thread>{};
+    threads.emplace_back(reader);
+    for (auto id = 0; id < Threads; ++id) {
+        threads.emplace_back(writer, id);
+    }
+    for (auto i = 1; i <= Threads; ++i) {
+        threads[i].join();
+    }
+    done.store(true);
+    threads[0].join();
+    auto count = 0;
+    for (auto beg = ilist.lower_bound(0); beg != ilist.cend(); ++beg, ++count) {
+        assert((beg->first / Threads) % 2 == 0);
+    }
+    assert(count == Threads * PerThread / 2);
+    assert(ilist.size() == Threads * PerThread / 2 + Stable);
+    printf("simultaneous insert(), erase() and range scans: pass\n");
+
+    // Erasers race with each other for the same keys
+    concurrent_skip_list<int, int, std::less<int>, Reclaimer> rlist{};
+    std::atomic<int> erased{ 0 };
+    auto racer = [&] {
+        for (auto k = 0; k < PerThread; ++k) {
+            rlist.insert(k, k);
+            erased += rlist.erase(k);
+            erased += rlist.erase(k - 1);
+        }
+    };
+    std::thread r1{ racer };
+    std::thread r2{ racer };
+    r1.join();
+    r2.join();
+    auto left = 0;
+    for (auto beg = rlist.cbegin(); beg != rlist.cend(); ++beg) {
+        ++left;
+    }
+    assert(rlist.size() == static_cast<size_t>(left));
+    printf("simultaneous erase() of the same keys: pass\n");
+    Reclaimer::collect();
+}
+
+int main()
+{
+    test_skip_list<epoch_reclaimer>("epoch_reclaimer");
+    test_skip_list<hazard_pointer_reclaimer>("hazard_pointer_reclaimer");
+    test_skip_list<epoch_reclaimer, node_pool_allocator<std::pair<const int, std::string>>>(
+        "epoch_reclaimer, node_pool_allocator");
+}
@@ -0,0 +1,625 @@
+#pragma once
+#include <type_traits>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <tuple>
+#include <cstddef>
+#include <cstdint>
+#include "reclamation.hpp"
+#include "tagged_link.hpp"
+#include "list_traversal.hpp"
+
+namespace hungbiu {
+
+namespace detail {
+
+// Reverse the bits of a word
+inline uint64_t reverse_bits(uint64_t x) noexcept
+{
+    x = ((x >> 1) & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+    x = ((x >> 2) & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+    x = ((x >> 4) & 0x0f0f0f0f0f0f0f0full) | ((x & 0x0f0f0f0f0f0f0f0full) << 4);
+    x = ((x >> 8) & 0x00ff00ff00ff00ffull) | ((x & 0x00ff00ff00ff00ffull) << 8);
+    x = ((x >> 16) & 0x0000ffff0000ffffull) | ((x & 0x0000ffff0000ffffull) << 16);
+    return (x >> 32) | (x << 32);
+}
+
+// Index of the highest set bit, x must not be 0
+inline unsigned highest_bit(uint64_t x) noexcept
+{
+    return 63u - static_cast<unsigned>(__builtin_clzll(x));
+}
+
+} // end of namespace detail
+
+// A concurrent hash map of unique keys on split-ordered lists (Shalev and
+// Shavit). All elements live in one lock-free list, the same Harris/Michael
+// list as concurrent_ordered_list, sorted by the bit-reversed hash. A bucket
+// is a dummy node in that list marking where its keys start, so doubling the
+// bucket count only makes the new buckets split the runs of their parents:
+// nothing is ever moved, and new buckets get their dummies lazily, the first
+// time an operation needs them.
+//
+// insert/erase are lock-free. Lookups are wait-free with a Reclaimer that
+// covers unlinked nodes (epoch_reclaimer), otherwise they search like
+// insert/erase and are lock-free.
+//
+// Reclaimer and Allocator are as in concurrent_forward_list.
+template<typename Key,
+         typename T,
+         typename Hash = std::hash<Key>,
+         typename KeyEqual = std::equal_to<Key>,
+         typename Reclaimer = epoch_reclaimer,
+         typename Allocator = std::allocator<std::pair<const Key, T>>>
+class concurrent_unordered_map
+{
+public:
+    typedef Key                     key_type;
+    typedef T                       mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef Hash                    hasher;
+    typedef KeyEqual                key_equal;
+    typedef Allocator               allocator_type;
+    typedef size_t                  size_type;
+private:
+    // Dummy nodes are bare list_nodes, elements are value_nodes.
+    // The split-order key m_so_key is the bit-reversed hash with
+    // the lowest bit set for elements, so a bucket's dummy sorts
+    // before all the elements hashing into it.
+    struct list_node
+    {
+        typedef list_node*                     pointer;
+        typedef detail::tagged_link<list_node> link_t;
+
+        // Data members
+        link_t      m_link;
+        uint64_t    m_so_key;
+
+        // Constructor
+        explicit list_node(uint64_t so_key) noexcept :
+            m_link(), m_so_key(so_key) {}
+        list_node(const list_node &) = delete;
+        list_node &operator= (const list_node &) = delete;
+
+        bool is_dummy() const noexcept {
+            return !(m_so_key & 1);
+        }
+        bool is_deleted() const noexcept {
+            return m_link.is_deleted();
+        }
+    };
+    struct value_node : list_node
+    {
+        value_type m_val;
+
+        template<typename... Args>
+        explicit value_node(uint64_t so_key, Args&&... args) :
+            list_node(so_key), m_val(std::forward<Args>(args)...) {}
+    };
+
+    typedef typename list_node::pointer pointer;
+    typedef typename list_node::link_t  link_t;
+    typedef typename Reclaimer::guard   guard_t;
+    typedef typename link_t::word_t     word_t;
+    typedef detail::list_traversal<list_node, Reclaimer> traversal;
+
+    typedef std::allocator_traits<Allocator>                                         alloc_traits;
+    typedef typename alloc_traits::template rebind_alloc<value_node>                 node_allocator;
+    typedef std::allocator_traits<node_allocator>                                    node_alloc_traits;
+    typedef typename alloc_traits::template rebind_alloc<list_node>                  dummy_allocator;
+    typedef std::allocator_traits<dummy_allocator>                                   dummy_alloc_traits;
+    static_assert( node_alloc_traits::is_always_equal::value,
+                   "retired nodes are freed with a default-constructed allocator" );
+
+    // Buckets are kept in segments that are allocated on first use and
+    // never move: segment 0 holds bucket 0, segment s > 0 holds buckets
+    // [2^(s-1), 2^s)
+    typedef std::atomic<pointer> bucket_t;
+    static constexpr unsigned Segments = 64;
+    static constexpr unsigned MinBucketsLog = 4;
+    // Average chain length above which the bucket count doubles
+    static constexpr size_t MaxLoadFactor = 2;
+
+    // Where a key belongs: *m_prev links to m_cur, the first node not
+    // ordered before the key, and held m_prev_word when read
+    struct position
+    {
+        link_t       *m_prev;
+        word_t        m_prev_word;
+        pointer       m_cur;
+    };
+    struct search_guards
+    {
+        guard_t m_prev;
+        guard_t m_cur;
+    };
+
+public:
+    // Elements are visited in split order, which is no particular order.
+    // Modifying the mapped value through an iterator is NOT thread-safe,
+    // and an iterator must not be shared across threads.
+template<typename Type>
+class concurrent_unordered_map_iterator
+{
+    public:
+        typedef Type                          value_type;
+        typedef list_node*                    pointer;
+        typedef value_type&                   reference;
+        typedef value_type*                   raw_pointer;
+    private:
+        pointer m_node_ptr = nullptr;
+        guard_t m_guard;    // Protects *m_node_ptr
+    public:
+    // Constructor
+    concurrent_unordered_map_iterator() noexcept {}
+    concurrent_unordered_map_iterator(const concurrent_unordered_map_iterator &oth) :
+        m_node_ptr(oth.m_node_ptr) { protect_copy(); }
+    template<typename U,
+             typename = std::enable_if_t<std::is_same_v< Type,
+                                                         std::add_const_t<U>> >
+                                        >
+    concurrent_unordered_map_iterator(const concurrent_unordered_map_iterator<U> &oth) :
+        m_node_ptr(oth.m_node_ptr) { protect_copy(); }
+    concurrent_unordered_map_iterator(concurrent_unordered_map_iterator &&oth) noexcept :
+        m_node_ptr(std::exchange(oth.m_node_ptr, nullptr)),
+        m_guard(std::move(oth.m_guard)) {}
+    ~concurrent_unordered_map_iterator() = default;
+
+    // Assignment operator
+    concurrent_unordered_map_iterator&
+    operator= (const concurrent_unordered_map_iterator &rhs) {
+        if (this != &rhs) {
+            m_node_ptr = rhs.m_node_ptr;
+            protect_copy();
+        }
+        return *this;
+    }
+    concurrent_unordered_map_iterator&
+    operator= (concurrent_unordered_map_iterator &&rhs) noexcept {
+        if (this != &rhs) {
+            m_node_ptr = std::exchange(rhs.m_node_ptr, nullptr);
+            m_guard = std::move(rhs.m_guard);
+        }
+        return *this;
+    }
+
+    // Relationship operator
+    friend bool
+    operator==( const concurrent_unordered_map_iterator &lhs,
+                const concurrent_unordered_map_iterator &rhs) noexcept {
+        return lhs.m_node_ptr == rhs.m_node_ptr;
+    }
+    friend bool
+    operator!=( const concurrent_unordered_map_iterator &lhs,
+                const concurrent_unordered_map_iterator &rhs) noexcept {
+        return lhs.m_node_ptr != rhs.m_node_ptr;
+    }
+
+    // Test if the iterator points to an element that is present in the map
+    bool is_valid() const noexcept{
+        return m_node_ptr &&
+               !m_node_ptr->is_deleted();
+    }
+    explicit operator bool() const noexcept{
+        return is_valid();
+    }
+
+    // Dereference
+    reference operator* () const noexcept {
+        return static_cast<value_node *>(m_node_ptr)->m_val;
+    }
+    raw_pointer operator-> () const noexcept {
+        return &(static_cast<value_node *>(m_node_ptr)->m_val);
+    }
+
+    // Advance forward
+    // Pre-increment
+    concurrent_unordered_map_iterator &operator++ ()
+    {
+        m_node_ptr = next_element(m_node_ptr, m_guard);
+        return *this;
+    }
+    // Post-increment
+    concurrent_unordered_map_iterator operator++ (int) {
+        auto tmp_iter = *this;
+        m_node_ptr = next_element(m_node_ptr, m_guard);
+        return tmp_iter;
+    }
+
+private:
+    // Take over a node protected by g
+    concurrent_unordered_map_iterator(pointer node_ptr, guard_t &&g) noexcept :
+        m_node_ptr(node_ptr), m_guard(std::move(g)) {}
+    void protect_copy() {
+        if (m_node_ptr) {
+            m_guard.set(m_node_ptr);
+        } else {
+            m_guard.reset();
+        }
+    }
+
+    friend class concurrent_unordered_map;
+    template<typename> friend class concurrent_unordered_map_iterator;
+};
+    typedef concurrent_unordered_map_iterator<value_type>       iterator;
+    typedef concurrent_unordered_map_iterator<const value_type> const_iterator;
+
+private:
+    mutable std::atomic<bucket_t *> m_segments[Segments];
+    std::atomic<unsigned>           m_buckets_log;  // bucket_count() is 2^m_buckets_log
+    std::atomic<size_t>             m_size{ 0 };
+    Hash                            m_hash;
+    KeyEqual                        m_eq;
+public:
+    // Constructor
+    // bucket_hint is rounded up to a power of two
+    explicit concurrent_unordered_map( size_t bucket_hint = size_t{ 1 } << MinBucketsLog,
+                                       const Hash &hash = Hash{},
+                                       const KeyEqual &eq = KeyEqual{} ) :
+        m_buckets_log(MinBucketsLog), m_hash(hash), m_eq(eq) {
+        for (auto &seg : m_segments) {
+            seg.store(nullptr, std::memory_order_relaxed);
+        }
+        while ((size_t{ 1 } << m_buckets_log.load()) < bucket_hint && m_buckets_log.load() < Segments - 1) {
+            m_buckets_log.fetch_add(1);
+        }
+        // Bucket 0 heads the whole list
+        bucket(0).store(create_dummy(0), std::memory_order_release);
+    }
+    concurrent_unordered_map(const concurrent_unordered_map &) = delete;
+    concurrent_unordered_map &operator= (const concurrent_unordered_map &) = delete;
+    // Not thread-safe: no other thread may access the map any more
+    ~concurrent_unordered_map() {
+        auto p = bucket(0).load(std::memory_order_acquire);
+        while (p) {
+            auto next = p->m_link.next();
+            if (p->is_dummy()) {
+                destroy_dummy(p);
+            } else {
+                destroy_node(p);
+            }
+            p = next;
+        }
+        for (auto s = 0u; s < Segments; ++s) {
+            delete[] m_segments[s].load(std::memory_order_relaxed);
+        }
+    }
+
+    // Iterators
+    iterator begin() {
+        auto g = guard_t{};
+        auto p = next_element(bucket(0).load(std::memory_order_acquire), g);
+        return iterator{ p, std::move(g) };
+    }
+    const_iterator cbegin() const {
+        auto g = guard_t{};
+        auto p = next_element(bucket(0).load(std::memory_order_acquire), g);
+        return const_iterator{ p, std::move(g) };
+    }
+    iterator end() noexcept {
+        return iterator{};
+    }
+    const_iterator cend() const noexcept {
+        return const_iterator{};
+    }
+
+    // Lookup
+    // --------------------------------------------------
+
+    bool contains(const Key &key) const {
+        auto g = guard_t{};
+        return find_node(key, g) != nullptr;
+    }
+    // Returns an iterator to the element with key, or end()
+    iterator find(const Key &key) {
+        auto g = guard_t{};
+        auto p = find_node(key, g);
+        return iterator{ p, std::move(g) };
+    }
+    const_iterator find(const Key &key) const {
+        auto g = guard_t{};
+        auto p = find_node(key, g);
+        return const_iterator{ p, std::move(g) };
+    }
+
+    // Modifiers
+    // --------------------------------------------------
+
+    // Insert key with the mapped value, unless key is already present
+    // Returns a bool indicates if the insertion actually take place
+    bool insert(const Key &key, const T &val) {
+        return emplace(key, val);
+    }
+    bool insert(const Key &key, T &&val) {
+        return emplace(key, std::move(val));
+    }
+    // Insert key with the mapped value constructed in place from args
+    // Returns a bool indicates if the insertion actually take place
+    template<typename... Args>
+    bool emplace(const Key &key, Args&&... args) {
+        auto h = static_cast<uint64_t>(m_hash(key));
+        auto so_key = element_key(h);
+        auto start = bucket_of(h);
+        auto sg = search_guards{};
+        auto pos = position{};
+        auto new_node = static_cast<value_node *>(nullptr);
+        for (;;) {
+            if (search(start, so_key, &key, pos, sg)) {
+                if (new_node) {
+                    destroy_node(new_node);
+                }
+                return false;
+            }
+            // Allocate once the key is known to be missing
+            if (!new_node) {
+                new_node = create_node( so_key,
+                                        std::piecewise_construct,
+                                        std::forward_as_tuple(key),
+                                        std::forward_as_tuple(std::forward<Args>(args)...) );
+            }
+            new_node->m_link.init(pos.m_cur);
+            if (pos.m_prev->compare_exchange(pos.m_prev_word, new_node)) {
+                break;
+            }
+        }
+        grow_if_loaded(m_size.fetch_add(1, std::memory_order_relaxed) + 1);
+        return true;
+    }
+    // Erase the element with key
+    // Returns a bool indicates if the erasure actually take place
+    bool erase(const Key &key) {
+        auto h = static_cast<uint64_t>(m_hash(key));
+        auto so_key = element_key(h);
+        auto start = bucket_of(h);
+        auto sg = search_guards{};
+        auto pos = position{};
+        for (;;) {
+            if (!search(start, so_key, &key, pos, sg)) {
+                return false;
+            }
+            auto cur = pos.m_cur;
+            auto w = cur->m_link.load();
+            if (link_t::is_deleted(w) || !cur->m_link.try_mark(w)) {
+                continue;   // Someone else erased it, or its successor changed
+            }
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+            // Erased. Unlink it, or leave it to a search that helps.
+            if (pos.m_prev->compare_exchange(pos.m_prev_word, link_t::pointer_of(w))) {
+                retire_node(cur);
+            } else {
+                search(start, so_key, &key, pos, sg);
+            }
+            return true;
+        }
+    }
+
+    // Capacity
+    // The count of elements, exact only while the map is not modified
+    size_t size() const noexcept {
+        return m_size.load(std::memory_order_relaxed);
+    }
+    bool empty() const noexcept {
+        return !size();
+    }
+
+    // Hash policy
+    size_t bucket_count() const noexcept {
+        return size_t{ 1 } << m_buckets_log.load(std::memory_order_relaxed);
+    }
+    float load_factor() const noexcept {
+        return static_cast<float>(size()) / bucket_count();
+    }
+    hasher hash_function() const {
+        return m_hash;
+    }
+    key_equal key_eq() const {
+        return m_eq;
+    }
+    allocator_type get_allocator() const noexcept {
+        return allocator_type{};
+    }
+
+private:
+    template<typename... Args>
+    static value_node *create_node(Args&&... args) {
+        auto alloc = node_allocator{};
+        auto p = node_alloc_traits::allocate(alloc, 1);
+        try {
+            node_alloc_traits::construct(alloc, p, std::forward<Args>(args)...);
+        } catch (...) {
+            node_alloc_traits::deallocate(alloc, p, 1);
+            throw;
+        }
+        return p;
+    }
+    static void destroy_node(void *p) {
+        auto alloc = node_allocator{};
+        auto node = static_cast<value_node *>(static_cast<list_node *>(p));
+        node_alloc_traits::destroy(alloc, node);
+        node_alloc_traits::deallocate(alloc, node, 1);
+    }
+    static void retire_node(pointer p) {
+        Reclaimer::retire(p, &destroy_node);
+    }
+    static pointer create_dummy(uint64_t bucket) {
+        auto alloc = dummy_allocator{};
+        auto p = dummy_alloc_traits::allocate(alloc, 1);
+        dummy_alloc_traits::construct(alloc, p, detail::reverse_bits(bucket));
+        return p;
+    }
+    static void destroy_dummy(pointer p) {
+        auto alloc = dummy_allocator{};
+        dummy_alloc_traits::destroy(alloc, p);
+        dummy_alloc_traits::deallocate(alloc, p, 1);
+    }
+
+    // Split-order key of an element
+    static uint64_t element_key(uint64_t h) noexcept {
+        return detail::reverse_bits(h) | 1;
+    }
+
+    // Buckets
+    // --------------------------------------------------
+
+    bucket_t &bucket(uint64_t b) const {
+        auto s = b ? detail::highest_bit(b) + 1 : 0u;
+        auto segment = m_segments[s].load(std::memory_order_acquire);
+        if (!segment) {
+            auto len = s ? size_t{ 1 } << (s - 1) : size_t{ 1 };
+            auto fresh = new bucket_t[len]();
+            if (m_segments[s].compare_exchange_strong(segment, fresh, std::memory_order_acq_rel)) {
+                segment = fresh;
+            } else {
+                delete[] fresh;
+            }
+        }
+        return segment[s ? b - (uint64_t{ 1 } << (s - 1)) : 0];
+    }
+    // The dummy of h's bucket, created first if it is missing
+    pointer bucket_of(uint64_t h) const {
+        auto mask = (uint64_t{ 1 } << m_buckets_log.load(std::memory_order_acquire)) - 1;
+        return dummy_of(h & mask);
+    }
+    pointer dummy_of(uint64_t b) const {
+        auto p = bucket(b).load(std::memory_order_acquire);
+        return p ? p : initialize_bucket(b);
+    }
+    // Link the dummy of bucket b into the list, behind its parent's,
+    // which is b without its highest bit
+    pointer initialize_bucket(uint64_t b) const {
+        auto parent = dummy_of(b & ~(uint64_t{ 1 } << detail::highest_bit(b)));
+        auto so_key = detail::reverse_bits(b);
+        auto sg = search_guards{};
+        auto pos = position{};
+        auto dummy = pointer{};
+        for (;;) {
+            if (search(parent, so_key, nullptr, pos, sg)) {
+                // Someone else linked it first
+                if (dummy) {
+                    destroy_dummy(dummy);
+                }
+                dummy = pos.m_cur;
+                break;
+            }
+            if (!dummy) {
+                dummy = create_dummy(b);
+            }
+            dummy->m_link.init(pos.m_cur);
+            if (pos.m_prev->compare_exchange(pos.m_prev_word, dummy)) {
+                break;
+            }
+        }
+        auto expected = pointer{};
+        bucket(b).compare_exchange_strong(expected, dummy, std::memory_order_acq_rel);
+        return dummy;
+    }
+    // Double the bucket count once the average chain gets too long
+    void grow_if_loaded(size_t count) {
+        auto log = m_buckets_log.load(std::memory_order_relaxed);
+        if ( count > MaxLoadFactor * (size_t{ 1 } << log) &&
+             log < Segments - 1 ) {
+            m_buckets_log.compare_exchange_strong(log, log + 1, std::memory_order_release);
+        }
+    }
+
+    // Search
+    // --------------------------------------------------
+
+    // True if node p is the element with key, or the dummy (key == nullptr)
+    // with split-order key so_key
+    bool matches(pointer p, uint64_t so_key, const Key *key) const {
+        return p->m_so_key == so_key &&
+               (!key || m_eq(static_cast<value_node *>(p)->m_val.first, *key));
+    }
+    // True if the nodes with split-order key so_key come after p
+    static bool ordered_before(pointer p, uint64_t so_key) noexcept {
+        return p->m_so_key <= so_key;
+    }
+    // Michael's search from the dummy start: find the position of the
+    // element with key (or the dummy with so_key, if key is nullptr),
+    // unlinking and retiring the marked nodes on the way. Elements with
+    // equal hashes sit next to each other in any order, so the search
+    // only stops at a node ordered after so_key or at a match.
+    // Returns true if pos.m_cur is the match.
+    bool search(pointer start, uint64_t so_key, const Key *key, position &pos, search_guards &sg) const {
+    retry:
+        auto prev = &start->m_link;     // Dummies are never erased
+        auto w = prev->load();
+        sg.m_prev.reset();
+        for (;;) {
+            auto cur = link_t::pointer_of(w);
+            if (!cur) {
+                pos = position{ prev, w, nullptr };
+                return false;
+            }
+            sg.m_cur.set(cur);
+            if (prev->load(std::memory_order_seq_cst) != w) {
+                goto retry;     // prev got marked or relinked
+            }
+            auto cw = cur->m_link.load();
+            if (link_t::is_deleted(cw)) {
+                // Help to unlink the erased cur, its unlinker retires it
+                auto next = link_t::pointer_of(cw);
+                if (!prev->compare_exchange(w, next)) {
+                    goto retry;
+                }
+                retire_node(cur);
+                w = link_t::to_word(next);
+                continue;
+            }
+            if (!ordered_before(cur, so_key) || matches(cur, so_key, key)) {
+                pos = position{ prev, w, cur };
+                return ordered_before(cur, so_key);
+            }
+            prev = &cur->m_link;
+            w = cw;
+            sg.m_prev.swap(sg.m_cur);
+        }
+    }
+    // Walk the links from the bucket without helping, which needs a
+    // Reclaimer that covers unlinked nodes. Returns the element with key,
+    // protected by g, or nullptr.
+    pointer wait_free_find(pointer start, uint64_t so_key, const Key &key, guard_t &g) const {
+        g.set(start);
+        auto cur = start->m_link.next();
+        while (cur && ordered_before(cur, so_key)) {
+            if (matches(cur, so_key, &key)) {
+                if (cur->is_deleted()) {
+                    break;
+                }
+                return cur;
+            }
+            cur = cur->m_link.next();
+        }
+        g.reset();
+        return nullptr;
+    }
+    pointer find_node(const Key &key, guard_t &g) const {
+        auto h = static_cast<uint64_t>(m_hash(key));
+        auto so_key = element_key(h);
+        auto start = bucket_of(h);
+        if constexpr (Reclaimer::covers_unlinked_nodes) {
+            return wait_free_find(start, so_key, key, g);
+        } else {
+            auto sg = search_guards{};
+            auto pos = position{};
+            if (!search(start, so_key, &key, pos, sg)) {
+                return nullptr;
+            }
+            g.swap(sg.m_cur);
+            return pos.m_cur;
+        }
+    }
+    // The first element after p, skipping dummies. p is a dummy or an
+    // element protected by g.
+    static pointer next_element(pointer p, guard_t &g) {
+        do {
+            p = traversal::advance(p, g);
+        } while (p && p->is_dummy());
+        return p;
+    }
+};
+
+}; // end of namespace hungbiu
@@ -0,0 +1,106 @@
+#include "concurrent_unordered_map.hpp"
+#include "node_pool.hpp"
+#include "benchmark.hpp"
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <memory>
+
+using namespace hungbiu;
+
+// Keys are drawn from [0, KeyRange), half of them are present at the start
+constexpr auto KeyRange = 1 << 16;
+
+template<typename Map>
+class cumap_subject
+{
+private:
+    Map m_map;
+public:
+    bool find(int k) const {
+        return m_map.contains(k);
+    }
+    void insert(int k) {
+        m_map.insert(k, k);
+    }
+    void erase(int k) {
+        m_map.erase(k);
+    }
+};
+
+// Baseline: std::unordered_map behind one std::shared_mutex
+class locked_unordered_map_subject
+{
+private:
+    mutable std::shared_mutex    m_mtx;
+    std::unordered_map<int, int> m_map;
+public:
+    bool find(int k) const {
+        auto lock = std::shared_lock<std::shared_mutex>{ m_mtx };
+        return m_map.find(k) != m_map.end();
+    }
+    void insert(int k) {
+        auto lock = std::lock_guard<std::shared_mutex>{ m_mtx };
+        m_map.emplace(k, k);
+    }
+    void erase(int k) {
+        auto lock = std::lock_guard<std::shared_mutex>{ m_mtx };
+        m_map.erase(k);
+    }
+};
+
+template<typename Subject>
+std::vector<bench::mix<Subject>> mixes()
+{
+    typedef bench::operation<Subject> op;
+    auto find = op{ "find", 18, [](Subject &s, std::mt19937_64 &rng, unsigned) {
+        bench::do_not_optimize(s.find(static_cast<int>(rng() % KeyRange)));
+    } };
+    auto insert = op{ "insert", 1, [](Subject &s, std::mt19937_64 &rng, unsigned) {
+        s.insert(static_cast<int>(rng() % KeyRange));
+    } };
+    auto erase = op{ "erase", 1, [](Subject &s, std::mt19937_64 &rng, unsigned) {
+        s.erase(static_cast<int>(rng() % KeyRange));
+    } };
+    auto find_half = find;
+    find_half.m_weight = 2;
+    return {
+        { "read_mostly", { find, insert, erase } },
+        { "balanced",    { find_half, insert, erase } },
+    };
+}
+
+template<typename Subject>
+void run_subject(const char *name, const bench::options &opts)
+{
+    if (!opts.wants_subject(name)) {
+        return;
+    }
+    for (auto &m : mixes<Subject>()) {
+        if (!opts.wants_mix(m.m_name)) {
+            continue;
+        }
+        for (auto threads : opts.thread_counts()) {
+            auto subject = std::make_unique<Subject>();
+            for (auto k = 0; k < KeyRange; k += 2) {
+                subject->insert(k);
+            }
+            auto r = bench::run(*subject, m, threads, opts.m_duration);
+            bench::print_result(name, m.m_name, threads, r);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    auto opts = bench::options{ argc, argv };
+    bench::print_header();
+    run_subject<locked_unordered_map_subject>("shared_mutex+std::unordered_map", opts);
+    run_subject<cumap_subject<concurrent_unordered_map<int, int>>>(
+        "cumap<epoch>", opts);
+    run_subject<cumap_subject<concurrent_unordered_map<int, int, std::hash<int>, std::equal_to<int>, hazard_pointer_reclaimer>>>(
+        "cumap<hazard>", opts);
+    run_subject<cumap_subject<concurrent_unordered_map<int, int, std::hash<int>, std::equal_to<int>, epoch_reclaimer,
+                                                       node_pool_allocator<std::pair<const int, int>>>>>(
+        "cumap<epoch,pool>", opts);
+}
@@ -0,0 +1,126 @@
+#include "concurrent_unordered_map.hpp"
+#include "node_pool.hpp"
+#include <thread>
+#include <stdio.h>
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <vector>
+
+using namespace hungbiu;
+
+// Sends every key to one of 4 hashes, to exercise collisions
+struct colliding_hash
+{
+    size_t operator() (int k) const noexcept {
+        return static_cast<size_t>(k % 4);
+    }
+};
+
+template< typename Reclaimer,
+          typename Allocator = std::allocator<std::pair<const int, std::string>>>
+void test_map(const char *name)
+{
+    printf("--- %s ---\n", name);
+    typedef concurrent_unordered_map<int, std::string, std::hash<int>, std::equal_to<int>, Reclaimer, Allocator> map_type;
+    map_type cumap{};
+    assert(cumap.empty());
+
+    // insert
+    constexpr auto Max = 1000;
+    for (auto k = 0; k < Max; ++k) {
+        assert(cumap.insert(k, std::to_string(k)));
+    }
+    assert(!cumap.insert(7, "seven"));
+    assert(cumap.size() == Max);
+    assert(cumap.bucket_count() * 2 >= Max);
+    printf("insert and grow: pass\n");
+
+    // find and contains
+    for (auto k = 0; k < Max; ++k) {
+        auto it = cumap.find(k);
+        assert(it != cumap.end() && it->second == std::to_string(k));
+    }
+    assert(!cumap.contains(Max));
+    assert(cumap.find(-1) == cumap.end());
+    auto count = 0;
+    for (auto it = cumap.cbegin(); it != cumap.cend(); ++it, ++count) {
+        assert(it->second == std::to_string(it->first));
+    }
+    assert(count == Max);
+    printf("find and iterate: pass\n");
+
+    // erase
+    auto it = cumap.find(10);
+    for (auto k = 0; k < Max; k += 2) {
+        assert(cumap.erase(k));
+    }
+    assert(!cumap.erase(0));
+    assert(!it.is_valid());
+    assert(!cumap.contains(10) && cumap.contains(11));
+    assert(cumap.size() == Max / 2);
+    printf("erase: pass\n");
+
+    // Colliding hashes
+    concurrent_unordered_map<int, int, colliding_hash, std::equal_to<int>, Reclaimer> cmap{};
+    for (auto k = 0; k < 100; ++k) {
+        assert(cmap.insert(k, -k));
+    }
+    for (auto k = 0; k < 100; k += 3) {
+        assert(cmap.erase(k));
+    }
+    for (auto k = 0; k < 100; ++k) {
+        assert(cmap.contains(k) == (k % 3 != 0));
+        assert(k % 3 == 0 || cmap.find(k)->second == -k);
+    }
+    printf("colliding hashes: pass\n");
+
+    // Threads insert and erase their own keys, interleaved with the
+    // others', while the table grows and readers look the keys up
+    concurrent_unordered_map<int, int, std::hash<int>, std::equal_to<int>, Reclaimer> imap{};
+    constexpr auto Threads = 4;
+    constexpr auto PerThread = 5000;
+    std::atomic<bool> done{ false };
+    auto writer = [&imap](int id) {
+        for (auto i = 0; i < PerThread; ++i) {
+            auto key = i * Threads + id;
+            assert(imap.insert(key, key));
+            assert(imap.contains(key));
+            if (i % 2) {
+                assert(imap.erase(key));
+                assert(!imap.contains(key));
+            }
+        }
+    };
+    auto reader = [&] {
+        while (!done.load()) {
+            for (auto beg = imap.cbegin(); beg != imap.cend(); ++beg) {
+                assert(beg->first == beg->second);
+            }
+        }
+    };
+    auto threads = std::vector<std::thread>{};
+    threads.emplace_back(reader);
+    for (auto id = 0; id < Threads; ++id) {
+        threads.emplace_back(writer, id);
+    }
+    for (auto i = 1; i <= Threads; ++i) {
+        threads[i].join();
+    }
+    done.store(true);
+    threads[0].join();
+    for (auto key = 0; key < Threads * PerThread; ++key) {
+        assert(imap.contains(key) == ((key / Threads) % 2 == 0));
+    }
+    assert(imap.size() == Threads * PerThread / 2);
+    printf("simultaneous insert(), erase() and contains(): pass\n");
+    Reclaimer::collect();
+}
+
+int main()
+{
+    test_map<epoch_reclaimer>("epoch_reclaimer");
+    test_map<hazard_pointer_reclaimer>("hazard_pointer_reclaimer");
+    test_map<epoch_reclaimer, node_pool_allocator<std::pair<const int, std::string>>>(
+        "epoch_reclaimer, node_pool_allocator");
+}
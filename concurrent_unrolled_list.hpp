@@ -0,0 +1,650 @@
+#pragma once
+#include <type_traits>
+#include <memory>
+#include <atomic>
+#include <mutex>  // std::unique_lock
+#include <optional>
+#include <utility>
+#include <iterator>
+#include <bitset>
+#include <cstdint>
+#include "reclamation.hpp"
+#include "tagged_link.hpp"
+#include "striped_counter.hpp"
+#include "cache_line.hpp"
+
+namespace hungbiu {
+
+namespace detail {
+
+// The index of the lowest set bit, bits must not be 0
+inline unsigned lowest_slot(uint64_t bits) noexcept
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+    auto i = 0u;
+    for (; !(bits & 1); bits >>= 1) {
+        ++i;
+    }
+    return i;
+#endif
+}
+
+} // end of namespace detail
+
+// A concurrent singly linked list that packs up to N elements into every
+// node (a block), so a traversal streams through arrays instead of
+// chasing a pointer per element. push_front/insert_after/erase_after keep
+// the semantics of concurrent_forward_list at element granularity.
+//
+// A block holds its elements in N slots, in list order, with a bitmap of
+// the occupied ones. Writers lock the blocks they change (the lock bit of
+// the block's link, predecessor before successor); readers never lock.
+// Instead, a writer bumps the block's version around every change, and a
+// reader copies a block and its link, retrying until it read one version
+// (a seqlock). Slots are atomics, so T must be trivially copyable with
+// lock-free atomics, e.g. int, double or a pointer.
+//
+// push_front fills the free slots of the head block from the back, with a
+// new head block once slot 0 is taken. insert_after fills the slot behind
+// its position if free, else shifts the following elements of the block
+// up to its next free slot, or, in a full block, moves them to a new block
+// linked behind it. Moved elements keep their place in the list, but
+// iterators at them turn stale, like iterators at erased elements: every
+// slot has a generation, bumped when its element leaves, that operations
+// on an iterator check under the block's lock. A block emptied by erasures
+// is unlinked by the next pop_front()/erase_after() that holds its
+// predecessor.
+//
+// Readers walk on through unlinked blocks, which requires a Reclaimer
+// that covers them. Allocator must be stateless, as in
+// concurrent_forward_list.
+template<typename T,
+         size_t N = 16,
+         typename Reclaimer = epoch_reclaimer,
+         typename Allocator = std::allocator<T>>
+class concurrent_unrolled_list
+{
+    static_assert( std::is_trivially_copyable_v<T> && std::atomic<T>::is_always_lock_free,
+                   "slots are read without locks, T must be trivially copyable with lock-free atomics" );
+    static_assert( N >= 2 && N <= 64, "the occupancy of a block is a 64-bit mask" );
+    static_assert( Reclaimer::covers_unlinked_nodes,
+                   "readers walk through unlinked blocks, which needs a Reclaimer that covers them" );
+private:
+    static constexpr uint64_t bit(unsigned i) noexcept {
+        return uint64_t{ 1 } << i;
+    }
+    // The slots behind slot i
+    static constexpr uint64_t above(unsigned i) noexcept {
+        return ~((bit(i) << 1) - 1);
+    }
+    static constexpr uint64_t AllSlots = N == 64 ? ~uint64_t{ 0 } : bit(N) - 1;
+
+    struct block
+    {
+        typedef block*                     pointer;
+        typedef detail::tagged_link<block> link_t;
+        typedef std::unique_lock<link_t>   unique_lock_t;
+
+        // Data members
+        mutable link_t        m_link;
+        // Odd while a writer changes the block
+        std::atomic<uint32_t> m_version{ 0 };
+        // Bit i is set if slot i holds an element
+        std::atomic<uint64_t> m_occupied{ 0 };
+        // Bumped whenever the element in slot i leaves it
+        std::atomic<uint32_t> m_generation[N];
+        std::atomic<T>        m_slots[N];
+
+        // Constructor
+        explicit block(pointer next) noexcept :
+            m_link(next) {
+            for (auto &g : m_generation) {
+                g.store(0, std::memory_order_relaxed);
+            }
+        }
+        block(const block &) = delete;
+        block &operator= (const block &) = delete;
+
+        // Operations
+        unique_lock_t lock() const noexcept {
+            return unique_lock_t{ m_link };
+        }
+        bool is_deleted() const noexcept {
+            return m_link.is_deleted();
+        }
+        pointer next() const noexcept {
+            return m_link.next();
+        }
+        // The lock must be held for the rest
+        uint64_t occupied() const noexcept {
+            return m_occupied.load(std::memory_order_relaxed);
+        }
+        // Changes to a published block go between these two
+        void begin_write() noexcept {
+            m_version.store(m_version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        void end_write() noexcept {
+            m_version.store(m_version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+        // Put val into the free slot i
+        void fill(unsigned i, const T &val) noexcept {
+            m_slots[i].store(val, std::memory_order_relaxed);
+            m_occupied.store(occupied() | bit(i), std::memory_order_relaxed);
+        }
+        // Take the element out of slot i
+        T vacate(unsigned i) noexcept {
+            auto val = m_slots[i].load(std::memory_order_relaxed);
+            retire_slot(i);
+            m_occupied.store(occupied() & ~bit(i), std::memory_order_relaxed);
+            return val;
+        }
+        // The element in slot i left, iterators at it are stale
+        void retire_slot(unsigned i) noexcept {
+            m_generation[i].store(m_generation[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        // True if slot i still holds the element of generation gen
+        bool holds(unsigned i, uint32_t gen) const noexcept {
+            return !is_deleted()
+                   && (occupied() & bit(i))
+                   && m_generation[i].load(std::memory_order_relaxed) == gen;
+        }
+    };
+
+    typedef block                       block_type;
+    typedef typename block::pointer     pointer;
+    typedef typename block::link_t      link_t;
+    typedef typename Reclaimer::guard   guard_t;
+    typedef typename link_t::word_t     word_t;
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<block_type> block_allocator;
+    typedef std::allocator_traits<block_allocator>                                       block_alloc_traits;
+    static_assert( block_alloc_traits::is_always_equal::value,
+                   "retired blocks are freed with a default-constructed allocator" );
+
+    // A copy of a block as of one version
+    struct block_view
+    {
+        uint64_t m_occupied = 0;
+        word_t   m_link = 0;
+        T        m_values[N];
+        uint32_t m_generation[N];
+    };
+
+public:
+    // An iterator holds a copy of the block it is in, taken when it
+    // entered the block, and a Reclaimer guard. Dereferencing reads the
+    // copy, so it never races with writers; is_valid() tells if the
+    // element is still in the list. Users should not use the same
+    // iterator across different threads.
+class concurrent_unrolled_list_iterator
+{
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T                         value_type;
+        typedef std::ptrdiff_t            difference_type;
+        typedef const T*                  pointer;
+        typedef const T&                  reference;
+    private:
+        block      *m_block = nullptr;
+        unsigned    m_slot = 0;
+        block_view  m_view;
+        guard_t     m_guard;    // Protects *m_block
+    public:
+    // Constructor
+    concurrent_unrolled_list_iterator() noexcept {}
+    concurrent_unrolled_list_iterator(const concurrent_unrolled_list_iterator &oth) :
+        m_block(oth.m_block), m_slot(oth.m_slot), m_view(oth.m_view) { protect_copy(); }
+    concurrent_unrolled_list_iterator(concurrent_unrolled_list_iterator &&oth) noexcept :
+        m_block(std::exchange(oth.m_block, nullptr)), m_slot(oth.m_slot),
+        m_view(oth.m_view), m_guard(std::move(oth.m_guard)) {}
+    ~concurrent_unrolled_list_iterator() = default;
+
+    // Assignment operator
+    concurrent_unrolled_list_iterator &
+    operator= (const concurrent_unrolled_list_iterator &rhs) {
+        if (this != &rhs) {
+            m_block = rhs.m_block;
+            m_slot = rhs.m_slot;
+            m_view = rhs.m_view;
+            protect_copy();
+        }
+        return *this;
+    }
+    concurrent_unrolled_list_iterator &
+    operator= (concurrent_unrolled_list_iterator &&rhs) noexcept {
+        if (this != &rhs) {
+            m_block = std::exchange(rhs.m_block, nullptr);
+            m_slot = rhs.m_slot;
+            m_view = rhs.m_view;
+            m_guard = std::move(rhs.m_guard);
+        }
+        return *this;
+    }
+
+    // Relationship operator
+    friend bool
+    operator==( const concurrent_unrolled_list_iterator &lhs,
+                const concurrent_unrolled_list_iterator &rhs) noexcept {
+        return lhs.m_block == rhs.m_block && (!lhs.m_block || lhs.m_slot == rhs.m_slot);
+    }
+    friend bool
+    operator!=( const concurrent_unrolled_list_iterator &lhs,
+                const concurrent_unrolled_list_iterator &rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    // Test if the element is still present in the list
+    bool is_valid() const noexcept {
+        return m_block
+               && !m_block->is_deleted()
+               && (m_block->m_occupied.load(std::memory_order_acquire) & bit(m_slot))
+               && m_block->m_generation[m_slot].load(std::memory_order_acquire) == m_view.m_generation[m_slot];
+    }
+    explicit operator bool() const noexcept {
+        return is_valid();
+    }
+
+    // Dereference
+    reference operator* () const noexcept {
+        return m_view.m_values[m_slot];
+    }
+    pointer operator-> () const noexcept {
+        return &m_view.m_values[m_slot];
+    }
+
+    // Advance forward, within the copy of the block, then on to the
+    // blocks it links to
+    concurrent_unrolled_list_iterator &operator++ () {
+        seek(above(m_slot));
+        return *this;
+    }
+    concurrent_unrolled_list_iterator operator++ (int) {
+        auto tmp_iter = *this;
+        seek(above(m_slot));
+        return tmp_iter;
+    }
+
+private:
+    // Start at the first element of the list
+    explicit concurrent_unrolled_list_iterator(const std::atomic<block *> &head) {
+        m_block = m_guard.protect(head);
+        if (m_block) {
+            read_block<true>(m_block, m_view);
+            seek(AllSlots);
+        }
+    }
+    // The first element of m_view among slots, or in the blocks behind
+    void seek(uint64_t slots) {
+        for (;;) {
+            auto bits = link_t::is_deleted(m_view.m_link) ? 0 : m_view.m_occupied & slots;
+            if (bits) {
+                m_slot = detail::lowest_slot(bits);
+                return;
+            }
+            m_block = link_t::pointer_of(m_view.m_link);
+            if (!m_block) {
+                m_guard.reset();
+                return;
+            }
+            m_guard.set(m_block);
+            read_block<true>(m_block, m_view);
+            slots = AllSlots;
+        }
+    }
+    // m_block is protected by the iterator copied from,
+    // so it can't be reclaimed before our guard is set
+    void protect_copy() {
+        if (m_block) {
+            m_guard.set(m_block);
+        } else {
+            m_guard.reset();
+        }
+    }
+
+    friend class concurrent_unrolled_list;
+};
+    typedef T                                  value_type;
+    typedef Allocator                          allocator_type;
+    typedef concurrent_unrolled_list_iterator  const_iterator;
+    typedef concurrent_unrolled_list_iterator  iterator;
+
+    static constexpr size_t block_capacity = N;
+
+private:
+    detail::striped_counter m_size;
+    alignas(detail::cache_line_size) std::atomic<pointer> m_head{ nullptr };
+public:
+    // Constructor
+    concurrent_unrolled_list() = default;
+    concurrent_unrolled_list(const concurrent_unrolled_list &) = delete;
+    // Not thread-safe: no other thread may access the list any more
+    ~concurrent_unrolled_list() {
+        auto p = m_head.load(std::memory_order_acquire);
+        while (p) {
+            auto next = p->next();
+            destroy_block(p);
+            p = next;
+        }
+    }
+    concurrent_unrolled_list &operator= (const concurrent_unrolled_list &) = delete;
+
+    // Iterators
+    const_iterator begin() const {
+        return const_iterator{ m_head };
+    }
+    const_iterator cbegin() const {
+        return const_iterator{ m_head };
+    }
+    const_iterator end() const noexcept {
+        return const_iterator{};
+    }
+    const_iterator cend() const noexcept {
+        return const_iterator{};
+    }
+
+    // Traversal
+    // Apply f to every element in list order under one Reclaimer guard.
+    // Each block is copied at one version and its elements are passed
+    // from the copy, so an element present throughout the walk is seen
+    // exactly once, even if a split moves it to another block meanwhile.
+    template<typename F>
+    void for_each(F f) const {
+        auto g = guard_t{};
+        auto v = block_view{};
+        for (auto p = g.protect(m_head); p; p = link_t::pointer_of(v.m_link)) {
+            read_block<false>(p, v);
+            if (link_t::is_deleted(v.m_link)) {
+                continue;   // Unlinked or cleared, its link is frozen
+            }
+            for (auto bits = v.m_occupied; bits; bits &= bits - 1) {
+                f(std::as_const(v.m_values[detail::lowest_slot(bits)]));
+            }
+        }
+    }
+
+    // Modifiers
+    // --------------------------------------------------
+
+    // Release all elements, the blocks are detached with one exchange
+    // on the head and sealed one by one, so operations still holding
+    // iterators into them fail
+    void clear() {
+        auto g = guard_t{};
+        auto p = m_head.exchange(nullptr, std::memory_order_acq_rel);
+        g.set(p);
+        while (p) {
+            auto lock = p->lock();
+            auto count = std::bitset<64>{ p->occupied() }.count();
+            p->begin_write();
+            p->m_link.mark_as_deleted();
+            p->end_write();
+            auto next = p->next();
+            lock.unlock();
+            retire_block(p);
+            m_size.sub(count);
+            p = next;
+        }
+    }
+    void push_front(const T &val) {
+        auto g = guard_t{};
+        auto fresh = pointer{};     // A new head block holding val
+        for (;;) {
+            auto h = g.protect(m_head);
+            if (!h) {
+                fresh = fresh ? fresh : create_block(nullptr, N - 1, val);
+                fresh->m_link.init(nullptr);
+                auto expected = pointer{};
+                if (m_head.compare_exchange_strong(expected, fresh, std::memory_order_release,
+                                                   std::memory_order_relaxed)) {
+                    break;
+                }
+                continue;
+            }
+            // The head only moves under the lock of the head block,
+            // or to null by clear(), which seals the block first
+            auto lock = h->lock();
+            if (h->is_deleted()) {
+                continue;
+            }
+            auto occ = h->occupied();
+            auto first = occ ? detail::lowest_slot(occ) : static_cast<unsigned>(N);
+            if (first > 0) {
+                h->begin_write();
+                h->fill(first - 1, val);
+                h->end_write();
+                if (fresh) {
+                    destroy_block(fresh);
+                }
+                break;
+            }
+            fresh = fresh ? fresh : create_block(nullptr, N - 1, val);
+            fresh->m_link.init(h);
+            auto expected = h;
+            if (m_head.compare_exchange_strong(expected, fresh, std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        m_size.add(1);
+    }
+    void pop_front() {
+        try_pop_front();
+    }
+    // Returns std::nullopt if the list is empty
+    std::optional<T> try_pop_front() {
+        auto g = guard_t{};
+        for (;;) {
+            auto h = g.protect(m_head);
+            if (!h) {
+                return std::nullopt;
+            }
+            auto lock = h->lock();
+            if (h->is_deleted()) {
+                continue;
+            }
+            if (auto occ = h->occupied()) {
+                h->begin_write();
+                auto val = h->vacate(detail::lowest_slot(occ));
+                h->end_write();
+                m_size.sub(1);
+                return val;
+            }
+            // An empty head block stays for pushes, unless a block follows
+            auto next = h->next();
+            if (!next) {
+                return std::nullopt;
+            }
+            auto expected = h;
+            if (!m_head.compare_exchange_strong(expected, next)) {
+                continue;   // Cleared
+            }
+            h->begin_write();
+            h->m_link.mark_as_deleted();
+            h->end_write();
+            lock.unlock();
+            retire_block(h);
+        }
+    }
+    // Insert an element after the specified position
+    // Returns a bool indicates if the insertion actually take place
+    bool insert_after(const const_iterator &pos, const T &val) {
+        auto p = pos.m_block;
+        if (!p) {
+            return false;
+        }
+        auto k = pos.m_slot;
+        auto fresh = pointer{};     // Only if the block has to be split
+        for (;;) {
+            auto lock = p->lock();
+            if (!p->holds(k, pos.m_view.m_generation[k])) {
+                if (fresh) {
+                    destroy_block(fresh);
+                }
+                return false;
+            }
+            auto occ = p->occupied();
+            auto free = ~occ & AllSlots & above(k);
+            if (free) {
+                // Shift the elements between k and the free slot up by one
+                auto j = detail::lowest_slot(free);
+                p->begin_write();
+                for (auto i = j; i > k + 1; --i) {
+                    p->fill(i, p->m_slots[i - 1].load(std::memory_order_relaxed));
+                    p->retire_slot(i - 1);
+                }
+                if (j > k + 1) {
+                    p->m_slots[k + 1].store(val, std::memory_order_relaxed);
+                } else {
+                    p->fill(k + 1, val);
+                }
+                p->end_write();
+                if (fresh) {
+                    destroy_block(fresh);
+                }
+                break;
+            }
+            if (!fresh) {
+                lock.unlock();
+                fresh = create_block(nullptr, k + 1 < N ? k : 0, val);
+                continue;
+            }
+            // A full block: the elements behind k move to a new block,
+            // keeping their slots, with val in front of them
+            auto tail = occ & above(k);
+            for (auto bits = tail; bits; bits &= bits - 1) {
+                auto i = detail::lowest_slot(bits);
+                fresh->fill(i, p->m_slots[i].load(std::memory_order_relaxed));
+            }
+            fresh->m_link.init(p->next());
+            p->begin_write();
+            for (auto bits = tail; bits; bits &= bits - 1) {
+                p->vacate(detail::lowest_slot(bits));
+            }
+            p->m_link.set_next(fresh);
+            p->end_write();
+            break;
+        }
+        m_size.add(1);
+        return true;
+    }
+    // Erase the element after the specified position
+    // Returns a bool indicates if the erasure actually take place
+    bool erase_after(const const_iterator &pos) {
+        auto p = pos.m_block;
+        if (!p) {
+            return false;
+        }
+        auto k = pos.m_slot;
+        auto lock = p->lock();
+        if (!p->holds(k, pos.m_view.m_generation[k])) {
+            return false;
+        }
+        if (auto later = p->occupied() & above(k)) {
+            p->begin_write();
+            p->vacate(detail::lowest_slot(later));
+            p->end_write();
+        } else if (!take_after(p)) {
+            return false;
+        }
+        m_size.sub(1);
+        return true;
+    }
+
+    // Capacity
+    bool empty() const {
+        return cbegin() == cend();
+    }
+    // As in concurrent_forward_list
+    size_t approx_size() const noexcept {
+        return m_size.approx();
+    }
+    size_t size() const noexcept {
+        return m_size.exact();
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return allocator_type{};
+    }
+
+private:
+    // A block with val in slot i
+    static pointer create_block(pointer next, unsigned i, const T &val) {
+        auto alloc = block_allocator{};
+        auto p = block_alloc_traits::allocate(alloc, 1);
+        block_alloc_traits::construct(alloc, p, next);
+        p->fill(i, val);
+        return p;
+    }
+    static void destroy_block(void *p) {
+        auto alloc = block_allocator{};
+        auto b = static_cast<pointer>(p);
+        block_alloc_traits::destroy(alloc, b);
+        block_alloc_traits::deallocate(alloc, b, 1);
+    }
+    static void retire_block(pointer p) {
+        Reclaimer::retire(p, &destroy_block);
+    }
+    // Copy b into v without locking it, retrying while a writer changes it
+    template<bool Generations>
+    static void read_block(const block *b, block_view &v) noexcept {
+        auto bo = detail::backoff{};
+        for (;;) {
+            auto version = b->m_version.load(std::memory_order_acquire);
+            if (!(version & 1)) {
+                v.m_occupied = b->m_occupied.load(std::memory_order_relaxed);
+                for (auto bits = v.m_occupied; bits; bits &= bits - 1) {
+                    auto i = detail::lowest_slot(bits);
+                    v.m_values[i] = b->m_slots[i].load(std::memory_order_relaxed);
+                    if constexpr (Generations) {
+                        v.m_generation[i] = b->m_generation[i].load(std::memory_order_relaxed);
+                    }
+                }
+                v.m_link = b->m_link.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (b->m_version.load(std::memory_order_relaxed) == version) {
+                    return;
+                }
+            }
+            bo.pause();
+        }
+    }
+    // Take the first element behind the locked block pre, unlinking the
+    // empty blocks on the way and the block emptied by taking it
+    // Returns std::nullopt if there is none
+    std::optional<T> take_after(pointer pre) {
+        for (;;) {
+            auto p = pre->next();
+            if (!p) {
+                return std::nullopt;
+            }
+            auto lock = p->lock();
+            auto occ = p->occupied();
+            auto val = std::optional<T>{};
+            if (occ) {
+                p->begin_write();
+                val = p->vacate(detail::lowest_slot(occ));
+                p->end_write();
+                if (occ & (occ - 1)) {
+                    return val;
+                }
+            }
+            // Mark before unlinking, as in concurrent_forward_list
+            p->begin_write();
+            p->m_link.mark_as_deleted();
+            p->end_write();
+            pre->begin_write();
+            pre->m_link.set_next(p->next());
+            pre->end_write();
+            lock.unlock();
+            retire_block(p);
+            if (val) {
+                return val;
+            }
+        }
+    }
+};
+
+}; // end of namespace hungbiu
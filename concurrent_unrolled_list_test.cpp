@@ -0,0 +1,179 @@
+#include "concurrent_unrolled_list.hpp"
+#include <thread>
+#include <stdio.h>
+#include <numeric>
+#include <atomic>
+#include <cassert>
+#include <vector>
+
+using namespace hungbiu;
+
+template<typename list_type>
+std::vector<int> contents(const list_type &lst)
+{
+    auto v = std::vector<int>{};
+    lst.for_each([&v](int x) { v.push_back(x); });
+    return v;
+}
+
+// The first element equal to val
+template<typename list_type>
+typename list_type::const_iterator find(const list_type &lst, int val)
+{
+    auto it = lst.cbegin();
+    while (it != lst.cend() && *it != val) {
+        ++it;
+    }
+    return it;
+}
+
+template<size_t N>
+void test_unrolled(const char *name)
+{
+    printf("--- %s ---\n", name);
+    typedef concurrent_unrolled_list<int, N> list_type;
+    list_type ulist;
+    assert(ulist.empty() && !ulist.try_pop_front() && ulist.cbegin() == ulist.cend());
+
+    // push_front
+    constexpr auto Max = 100;
+    for (auto i = Max; i >= 1; --i) {
+        ulist.push_front(i);
+    }
+    assert(std::accumulate(ulist.cbegin(), ulist.cend(), 0) == (1 + Max) * Max / 2);
+    auto expected = std::vector<int>(Max);
+    std::iota(expected.begin(), expected.end(), 1);
+    assert(contents(ulist) == expected && ulist.size() == Max);
+    printf("push_front: pass\n");
+
+    // pop_front
+    assert(ulist.try_pop_front() == 1);
+    ulist.pop_front();
+    assert(*ulist.cbegin() == 3 && ulist.size() == Max - 2);
+    ulist.push_front(2);
+    ulist.push_front(1);
+    printf("pop_front: pass\n");
+
+    // insert_after shifts or splits full blocks, the moved elements keep
+    // their place and iterators at them turn stale
+    auto moved = find(ulist, 3);
+    auto pos = find(ulist, 2);
+    assert(ulist.insert_after(pos, -1) && ulist.insert_after(pos, -2));
+    assert(!moved.is_valid() && !ulist.insert_after(moved, 0) && !ulist.erase_after(moved));
+    assert(pos.is_valid());
+    expected.insert(expected.begin() + 2, { -2, -1 });
+    assert(contents(ulist) == expected);
+    for (auto i = 10; i <= Max; i += 10) {
+        assert(ulist.insert_after(find(ulist, i), -i));
+        expected.insert(std::find(expected.begin(), expected.end(), i) + 1, -i);
+    }
+    auto last = find(ulist, -Max);
+    assert(ulist.insert_after(last, -Max - 1) && !ulist.erase_after(find(ulist, -Max - 1)));
+    expected.push_back(-Max - 1);
+    assert(contents(ulist) == expected && ulist.size() == expected.size());
+    auto via_iterators = std::vector<int>(ulist.cbegin(), ulist.cend());
+    assert(via_iterators == expected);
+    printf("insert_after: pass\n");
+
+    // erase_after, across blocks and through emptied ones
+    for (auto it = ulist.cbegin(); it != ulist.cend(); ++it) {
+        if (*it == 50) {
+            for (auto i = 0; i < 20; ++i) {
+                assert(ulist.erase_after(it));
+            }
+            break;
+        }
+    }
+    auto at = std::find(expected.begin(), expected.end(), 50) + 1;
+    expected.erase(at, at + 20);
+    assert(contents(ulist) == expected && ulist.size() == expected.size());
+    auto erased = find(ulist, 2);
+    assert(ulist.erase_after(ulist.cbegin()) && !erased.is_valid() && *erased == 2);
+    expected.erase(expected.begin() + 1);
+    assert(contents(ulist) == expected);
+    printf("erase_after: pass\n");
+
+    // Pop everything, then reuse the empty head block
+    while (ulist.try_pop_front()) ;
+    assert(ulist.empty() && ulist.size() == 0);
+    ulist.push_front(7);
+    assert(contents(ulist) == std::vector<int>{ 7 });
+    ulist.clear();
+    assert(ulist.empty() && ulist.size() == 0 && !ulist.try_pop_front());
+    printf("clear: pass\n");
+    epoch_reclaimer::collect();
+}
+
+template<size_t N>
+void test_simultaneous(const char *name)
+{
+    printf("--- simultaneous, %s ---\n", name);
+    typedef concurrent_unrolled_list<int, N> list_type;
+    list_type ulist;
+
+    // Stable elements 0..Stable-1 in order; writers insert markers behind
+    // keys of their own and erase them again, splitting and shifting the
+    // blocks under the readers; one more thread pushes and pops a marker
+    // at the front
+    constexpr auto Stable = 200;
+    constexpr auto Writers = 3;
+    constexpr auto Count = 1000;
+    for (auto i = Stable - 1; i >= 0; --i) {
+        ulist.push_front(i);
+    }
+    auto done = std::atomic<int>{ 0 };
+    auto threads = std::vector<std::thread>{};
+    for (auto w = 0; w < Writers; ++w) {
+        threads.emplace_back([&, w] {
+            for (auto j = 0; j < Count; ++j) {
+                auto key = (j * 7 * Writers + w) % Stable;
+                while (!ulist.insert_after(find(ulist, key), -1)) ;
+                while (!ulist.erase_after(find(ulist, key))) ;
+            }
+            ++done;
+        });
+    }
+    threads.emplace_back([&] {
+        for (auto j = 0; j < Count; ++j) {
+            ulist.push_front(-2);
+            assert(ulist.try_pop_front() == -2);
+        }
+        ++done;
+    });
+
+    // Every stable element is seen exactly once, in order
+    auto scans = 0;
+    while (done.load() < Writers + 1 || scans < 2) {
+        auto next = 0;
+        ulist.for_each([&next](int v) {
+            if (v >= 0) {
+                assert(v == next++);
+            }
+        });
+        assert(next == Stable);
+        next = 0;
+        for (auto it = ulist.cbegin(); it != ulist.cend(); ++it) {
+            if (*it >= 0) {
+                assert(*it == next++);
+            }
+        }
+        assert(next == Stable);
+        ++scans;
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    auto expected = std::vector<int>(Stable);
+    std::iota(expected.begin(), expected.end(), 0);
+    assert(contents(ulist) == expected && ulist.size() == Stable);
+    printf("simultaneous insert_after(), erase_after(), push_front(), pop_front() and scans: pass\n");
+    epoch_reclaimer::collect();
+}
+
+int main()
+{
+    test_unrolled<4>("N = 4");
+    test_unrolled<64>("N = 64");
+    test_simultaneous<4>("N = 4");
+    test_simultaneous<16>("N = 16");
+}
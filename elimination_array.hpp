@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "tagged_link.hpp"
+#include "cache_line.hpp"
+
+namespace hungbiu {
+
+namespace detail {
+
+// A side array where a push and a pop that both lost a CAS on a contended
+// head can meet and cancel out without touching the list (Hendler, Shavit
+// & Yerushalmi, 2004). A push offers its unpublished node in a random slot
+// and waits there briefly; a pop passing by takes it. The pair then
+// linearizes as the push immediately followed by the pop.
+//
+// Only pushes wait, so a pop never stalls here, it just tries one slot.
+template<typename Node>
+class elimination_array
+{
+public:
+    static constexpr unsigned Width    = 8;     // Slots to spread over
+    static constexpr unsigned Patience = 256;   // Pauses a push waits for a pop
+private:
+    typedef std::uintptr_t word_t;
+
+    // Slot words: Empty, an offered node, or Taken until its pusher sees it
+    static constexpr word_t Empty = 0;
+    static constexpr word_t Taken = 1;
+
+    struct alignas(cache_line_size) slot
+    {
+        std::atomic<word_t> m_word{ Empty };
+    };
+    slot m_slots[Width];
+
+    static unsigned random_index() noexcept {
+        thread_local std::uint32_t state = 0x9e3779b9u ^ static_cast<std::uint32_t>(
+                                               reinterpret_cast<std::uintptr_t>(&state));
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state % Width;
+    }
+public:
+    // Offer p, which no other thread can reach yet, to a pop.
+    // Returns true if a pop took it, it then owns p.
+    bool offer(Node *p) noexcept {
+        auto &s = m_slots[random_index()];
+        auto w = Empty;
+        if (!s.m_word.compare_exchange_strong(w, reinterpret_cast<word_t>(p),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+            return false;
+        }
+        for (auto i = 0u; i < Patience && s.m_word.load(std::memory_order_relaxed) != Taken; ++i) {
+            cpu_relax();
+        }
+        // Withdraw, unless a pop took p meanwhile
+        w = reinterpret_cast<word_t>(p);
+        if (s.m_word.compare_exchange_strong(w, Empty, std::memory_order_relaxed)) {
+            return false;
+        }
+        s.m_word.store(Empty, std::memory_order_relaxed);
+        return true;
+    }
+    // Returns a node some push offered, now owned by the caller, or nullptr
+    Node *take() noexcept {
+        auto &s = m_slots[random_index()];
+        auto w = s.m_word.load(std::memory_order_relaxed);
+        if (w == Empty || w == Taken
+            || !s.m_word.compare_exchange_strong(w, Taken,
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return reinterpret_cast<Node *>(w);
+    }
+};
+
+} // end of namespace detail
+
+}; // end of namespace hungbiu
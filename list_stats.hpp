@@ -0,0 +1,179 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+// Statistics policies of concurrent_forward_list: the list reports to its
+// Stats policy how its modifiers go, no_stats discards the reports at no
+// cost, thread_stats counts them per thread.
+
+namespace hungbiu {
+
+// The operations whose contention is counted
+enum class list_op { push_front, pop_front, insert_after, erase_after };
+
+// What happened to one operation, summed over threads
+struct op_counters
+{
+    uint64_t m_calls = 0;
+    uint64_t m_cas_attempts = 0;
+    uint64_t m_cas_failures = 0;
+    uint64_t m_lock_waits = 0;      // Lock acquisitions that had to wait
+    uint64_t m_lock_wait_ns = 0;    // Time spent waiting for them
+    uint64_t m_stale = 0;           // Failed since a position was erased under it
+
+    op_counters &operator-= (const op_counters &rhs) noexcept {
+        m_calls -= rhs.m_calls;
+        m_cas_attempts -= rhs.m_cas_attempts;
+        m_cas_failures -= rhs.m_cas_failures;
+        m_lock_waits -= rhs.m_lock_waits;
+        m_lock_wait_ns -= rhs.m_lock_wait_ns;
+        m_stale -= rhs.m_stale;
+        return *this;
+    }
+};
+
+struct list_stats_snapshot
+{
+    static constexpr size_t OpCount = 4;
+
+    op_counters m_ops[OpCount];
+
+    op_counters &operator[] (list_op op) noexcept {
+        return m_ops[static_cast<size_t>(op)];
+    }
+    const op_counters &operator[] (list_op op) const noexcept {
+        return m_ops[static_cast<size_t>(op)];
+    }
+    // The counts between an earlier snapshot and this one
+    list_stats_snapshot &operator-= (const list_stats_snapshot &rhs) noexcept {
+        for (size_t i = 0; i < OpCount; ++i) {
+            m_ops[i] -= rhs.m_ops[i];
+        }
+        return *this;
+    }
+    friend list_stats_snapshot operator- (list_stats_snapshot lhs, const list_stats_snapshot &rhs) noexcept {
+        return lhs -= rhs;
+    }
+};
+
+struct no_stats
+{
+    static constexpr bool enabled = false;
+
+    static void call(list_op) noexcept {}
+    static void cas(list_op, bool) noexcept {}
+    static void lock_wait(list_op, uint64_t) noexcept {}
+    static void stale(list_op) noexcept {}
+};
+
+// Each thread counts into its own record with plain relaxed stores, so
+// counting adds no shared writes to the hot paths; snapshot() sums the
+// records of all threads, including those that exited. Lists with the
+// same Tag share the counters, give a list its own Tag to tell it apart.
+template<typename Tag = void>
+class thread_stats
+{
+private:
+    enum field { Calls, CasAttempts, CasFailures, LockWaits, LockWaitNs, Stale, FieldCount };
+
+    struct record
+    {
+        std::atomic<uint64_t> m_counts[list_stats_snapshot::OpCount][FieldCount] = {};
+
+        void bump(list_op op, field f, uint64_t n = 1) noexcept {
+            auto &c = m_counts[static_cast<size_t>(op)][f];
+            c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+        void add_to(list_stats_snapshot &s) const noexcept {
+            for (size_t i = 0; i < list_stats_snapshot::OpCount; ++i) {
+                auto &o = s.m_ops[i];
+                o.m_calls += m_counts[i][Calls].load(std::memory_order_relaxed);
+                o.m_cas_attempts += m_counts[i][CasAttempts].load(std::memory_order_relaxed);
+                o.m_cas_failures += m_counts[i][CasFailures].load(std::memory_order_relaxed);
+                o.m_lock_waits += m_counts[i][LockWaits].load(std::memory_order_relaxed);
+                o.m_lock_wait_ns += m_counts[i][LockWaitNs].load(std::memory_order_relaxed);
+                o.m_stale += m_counts[i][Stale].load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+    // Records of the live threads, and the sum of those that exited
+    struct registry
+    {
+        std::mutex           m_mtx;
+        std::vector<record*> m_live;
+        list_stats_snapshot  m_exited;
+
+        // Never destroyed: threads may still exit during static destruction
+        static registry &instance() {
+            static auto *r = new registry;
+            return *r;
+        }
+    };
+
+    struct thread_record
+    {
+        record m_rec;
+
+        thread_record() {
+            auto &r = registry::instance();
+            auto lock = std::lock_guard<std::mutex>{ r.m_mtx };
+            r.m_live.push_back(&m_rec);
+        }
+        ~thread_record() {
+            auto &r = registry::instance();
+            auto lock = std::lock_guard<std::mutex>{ r.m_mtx };
+            m_rec.add_to(r.m_exited);
+            r.m_live.erase(std::find(r.m_live.begin(), r.m_live.end(), &m_rec));
+        }
+    };
+
+    static record &local() {
+        thread_local thread_record r;
+        return r.m_rec;
+    }
+public:
+    static constexpr bool enabled = true;
+
+    static void call(list_op op) noexcept {
+        local().bump(op, Calls);
+    }
+    static void cas(list_op op, bool succeeded) noexcept {
+        auto &r = local();
+        r.bump(op, CasAttempts);
+        if (!succeeded) {
+            r.bump(op, CasFailures);
+        }
+    }
+    static void lock_wait(list_op op, uint64_t ns) noexcept {
+        auto &r = local();
+        r.bump(op, LockWaits);
+        r.bump(op, LockWaitNs, ns);
+    }
+    static void stale(list_op op) noexcept {
+        local().bump(op, Stale);
+    }
+
+    // The calling thread's counts
+    static list_stats_snapshot thread_snapshot() {
+        auto s = list_stats_snapshot{};
+        local().add_to(s);
+        return s;
+    }
+    // The counts of all threads, each read at a slightly different moment
+    static list_stats_snapshot snapshot() {
+        auto s = list_stats_snapshot{};
+        auto &r = registry::instance();
+        auto lock = std::lock_guard<std::mutex>{ r.m_mtx };
+        s = r.m_exited;
+        for (auto rec : r.m_live) {
+            rec->add_to(s);
+        }
+        return s;
+    }
+};
+
+}; // end of namespace hungbiu
@@ -0,0 +1,161 @@
+#pragma once
+#include <atomic>
+#include "tagged_link.hpp"
+
+// Read-side traversal shared by the lists of this library, for nodes that
+// reach their successor through a tagged_link m_link and are erased by
+// marking it (see tagged_link.hpp).
+
+namespace hungbiu {
+
+namespace detail {
+
+template<typename Node, typename Reclaimer>
+struct list_traversal
+{
+    typedef tagged_link<Node>           link_t;
+    typedef typename link_t::word_t     word_t;
+    typedef typename Reclaimer::guard   guard_t;
+
+    // A link that traversal starts from: a plain head pointer or
+    // a tagged link (of a node or a sentinel)
+    struct head_anchor
+    {
+        const std::atomic<Node *> &m_head;
+
+        word_t load(std::memory_order order) const noexcept {
+            return link_t::to_word(m_head.load(order));
+        }
+    };
+    struct link_anchor
+    {
+        const link_t &m_link;
+
+        word_t load(std::memory_order order) const noexcept {
+            return m_link.load(order);
+        }
+    };
+
+    // Protect the first node behind anchor that is not marked deleted,
+    // moving the protection held by g there. Marked nodes have frozen
+    // links and stay linked while their predecessor still links to them,
+    // so a run of them is skipped as long as anchor keeps its link.
+    // Links leaving an unlinked node can only be trusted if the Reclaimer
+    // covers unlinked nodes; otherwise an anchor that got erased ends
+    // the traversal.
+    template<typename Anchor>
+    static Node *first_live(const Anchor &anchor, guard_t &g) {
+        auto next_guard = guard_t{};
+        auto skip_guard = guard_t{};
+        return first_live(anchor, g, next_guard, skip_guard);
+    }
+    // As above, with scratch guards the caller keeps across steps
+    template<typename Anchor>
+    static Node *first_live(const Anchor &anchor, guard_t &g, guard_t &next_guard, guard_t &skip_guard) {
+        auto w = anchor.load(std::memory_order_acquire);
+        for (;;) {
+            auto next = link_t::pointer_of(w);
+            if (!next) {
+                break;
+            }
+            next_guard.set(next);
+            if (!anchor_holds(anchor, w)) {
+                continue;
+            }
+            // Skip the nodes already erased
+            auto stale = false;
+            for (;;) {
+                auto nw = next->m_link.load();
+                if (!link_t::is_deleted(nw)) {
+                    g.swap(next_guard);
+                    return next;
+                }
+                next = link_t::pointer_of(nw);
+                if (!next) {
+                    break;
+                }
+                skip_guard.set(next);
+                if constexpr (!Reclaimer::covers_unlinked_nodes) {
+                    if (!anchor_holds(anchor, w)) {
+                        stale = true;
+                        break;
+                    }
+                }
+                next_guard.swap(skip_guard);
+            }
+            if (!stale) {
+                break;
+            }
+        }
+        g.reset();
+        return nullptr;
+    }
+    // Re-read the anchor after publishing a guard. Returns true if it still
+    // links as w was read; otherwise w receives the new word, or the null
+    // word if the traversal has to stop.
+    template<typename Anchor>
+    static bool anchor_holds(const Anchor &anchor, word_t &w) {
+        auto again = anchor.load(std::memory_order_seq_cst);
+        if constexpr (!Reclaimer::covers_unlinked_nodes) {
+            if (link_t::is_deleted(again)) {
+                w = 0;
+                return false;
+            }
+        }
+        // Lock bit flips don't change the target
+        if (link_t::same_link(again, w)) {
+            return true;
+        }
+        w = again;
+        return false;
+    }
+    // Step from the protected node cur to its successor
+    static Node *advance(const Node *cur, guard_t &g) {
+        return first_live(link_anchor{ cur->m_link }, g);
+    }
+
+    // Call visit(node) on the live nodes behind anchor, in order, until it
+    // returns false. Returns the node it stopped at, protected by g, or
+    // nullptr once the end is reached.
+    // If the Reclaimer covers unlinked nodes, the first protection covers
+    // the whole walk: the links are followed with plain acquire loads and
+    // nothing is published per node. Otherwise the walk steps like
+    // advance(), reusing the same three guards throughout.
+    template<typename Anchor, typename Visit>
+    static Node *visit_live(const Anchor &anchor, guard_t &g, Visit &&visit) {
+        if constexpr (Reclaimer::covers_unlinked_nodes) {
+            auto w = anchor.load(std::memory_order_acquire);
+            for (;;) {
+                if (!link_t::pointer_of(w)) {
+                    g.reset();
+                    return nullptr;
+                }
+                g.set(link_t::pointer_of(w));
+                if (anchor_holds(anchor, w)) {
+                    break;
+                }
+            }
+            for (auto p = link_t::pointer_of(w); p; ) {
+                auto nw = p->m_link.load(std::memory_order_acquire);
+                if (!link_t::is_deleted(nw) && !visit(p)) {
+                    return p;
+                }
+                p = link_t::pointer_of(nw);
+            }
+            g.reset();
+            return nullptr;
+        } else {
+            auto next_guard = guard_t{};
+            auto skip_guard = guard_t{};
+            auto p = first_live(anchor, g, next_guard, skip_guard);
+            while (p && visit(p)) {
+                p = first_live(link_anchor{ p->m_link }, g, next_guard, skip_guard);
+            }
+            return p;
+        }
+    }
+};
+
+} // end of namespace detail
+
+}; // end of namespace hungbiu
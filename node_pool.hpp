@@ -0,0 +1,223 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <type_traits>
+
+// A size-class pool for container nodes. Each thread keeps a free list per
+// size class; surplus blocks travel to and from a global depot in fixed-size
+// batches, so the steady-state churn of a container (nodes allocated by one
+// thread, retired and freed by another) never reaches the global heap.
+//
+// Storage is carved from slabs that are kept for the lifetime of the program.
+
+namespace hungbiu {
+
+namespace detail {
+
+struct pool_block
+{
+    pool_block *m_next;
+};
+
+// Global store of free batches and slabs for one block size
+template<size_t BlockSize>
+class pool_depot
+{
+public:
+    static constexpr size_t BatchSize = 64;
+    static constexpr size_t SlabSize  = 64 * 1024;
+private:
+    struct batch
+    {
+        pool_block *m_head;
+        size_t      m_count;
+    };
+
+    std::mutex         m_mtx;
+    std::vector<batch> m_batches;
+    char              *m_cursor = nullptr;   // Uncarved part of the current slab
+    char              *m_end = nullptr;
+public:
+    // Never destroyed: threads may still free blocks during static destruction
+    static pool_depot &instance() {
+        static auto *depot = new pool_depot;
+        return *depot;
+    }
+
+    // Hand out a chain of up to BatchSize blocks, count receives its length
+    pool_block *take(size_t &count) {
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        if (!m_batches.empty()) {
+            auto b = m_batches.back();
+            m_batches.pop_back();
+            count = b.m_count;
+            return b.m_head;
+        }
+        if (m_cursor == m_end) {
+            m_cursor = static_cast<char *>(::operator new(SlabSize));
+            m_end = m_cursor + SlabSize / BlockSize * BlockSize;
+        }
+        auto head = static_cast<pool_block *>(nullptr);
+        for (count = 0; count < BatchSize && m_cursor != m_end; ++count) {
+            auto b = reinterpret_cast<pool_block *>(m_cursor);
+            b->m_next = head;
+            head = b;
+            m_cursor += BlockSize;
+        }
+        return head;
+    }
+    void give(pool_block *head, size_t count) {
+        if (!head) {
+            return;
+        }
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        m_batches.push_back(batch{ head, count });
+    }
+};
+
+// Per-thread free list for one block size
+template<size_t BlockSize>
+class pool_cache
+{
+private:
+    typedef pool_depot<BlockSize> depot_type;
+    static constexpr size_t BatchSize = depot_type::BatchSize;
+
+    pool_block *m_free = nullptr;
+    size_t      m_count = 0;
+
+    pool_cache() = default;
+    // Reclaimers may still free nodes from the destructors of other
+    // thread-local objects, those blocks then go straight to the depot
+    ~pool_cache() {
+        exited() = true;
+        depot_type::instance().give(m_free, m_count);
+    }
+
+    static pool_cache &local() noexcept {
+        thread_local pool_cache cache;
+        return cache;
+    }
+    // Set once the thread's cache is destroyed. Kept outside the cache,
+    // in a trivially destructible thread-local that stays readable until
+    // the thread is gone.
+    static bool &exited() noexcept {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    void *take() {
+        if (!m_free) {
+            m_free = depot_type::instance().take(m_count);
+        }
+        auto b = m_free;
+        m_free = b->m_next;
+        --m_count;
+        return b;
+    }
+    void put(pool_block *b) {
+        b->m_next = m_free;
+        m_free = b;
+        // Keep one batch at hand, return the other to the depot
+        if (++m_count == 2 * BatchSize) {
+            auto surplus = m_free;
+            auto last = m_free;
+            for (size_t i = 1; i < BatchSize; ++i) {
+                last = last->m_next;
+            }
+            m_free = last->m_next;
+            last->m_next = nullptr;
+            m_count -= BatchSize;
+            depot_type::instance().give(surplus, BatchSize);
+        }
+    }
+public:
+    pool_cache(const pool_cache &) = delete;
+    pool_cache &operator= (const pool_cache &) = delete;
+
+    static void *allocate() {
+        if (exited()) {
+            auto count = size_t{ 0 };
+            auto b = depot_type::instance().take(count);
+            depot_type::instance().give(b->m_next, count - 1);
+            return b;
+        }
+        return local().take();
+    }
+    static void deallocate(void *p) {
+        auto b = static_cast<pool_block *>(p);
+        if (exited()) {
+            b->m_next = nullptr;
+            depot_type::instance().give(b, 1);
+            return;
+        }
+        local().put(b);
+    }
+};
+
+constexpr size_t pool_granularity = alignof(std::max_align_t);
+constexpr size_t pool_max_block   = 512;
+
+constexpr size_t pool_block_size(size_t size) noexcept {
+    return (size + pool_granularity - 1) / pool_granularity * pool_granularity;
+}
+
+} // end of namespace detail
+
+// Stateless allocator drawing single objects from the size-class pool.
+// Arrays, over-aligned and large types fall back to the global heap.
+template<typename T>
+class node_pool_allocator
+{
+public:
+    typedef T               value_type;
+    typedef std::true_type  is_always_equal;
+
+    template<typename U>
+    struct rebind { typedef node_pool_allocator<U> other; };
+
+    node_pool_allocator() noexcept = default;
+    template<typename U>
+    node_pool_allocator(const node_pool_allocator<U> &) noexcept {}
+
+    T *allocate(size_t n) {
+        if constexpr (pooled) {
+            if (n == 1) {
+                return static_cast<T *>(cache::allocate());
+            }
+        }
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{ alignof(T) }));
+        } else {
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+    }
+    void deallocate(T *p, size_t n) noexcept {
+        if constexpr (pooled) {
+            if (n == 1) {
+                cache::deallocate(p);
+                return;
+            }
+        }
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(p, n * sizeof(T), std::align_val_t{ alignof(T) });
+        } else {
+            ::operator delete(p, n * sizeof(T));
+        }
+    }
+
+    friend bool operator== (const node_pool_allocator &, const node_pool_allocator &) noexcept {
+        return true;
+    }
+    friend bool operator!= (const node_pool_allocator &, const node_pool_allocator &) noexcept {
+        return false;
+    }
+private:
+    static constexpr bool pooled = sizeof(T) <= detail::pool_max_block
+                                   && alignof(T) <= detail::pool_granularity;
+    typedef detail::pool_cache<detail::pool_block_size(sizeof(T))> cache;
+};
+
+}; // end of namespace hungbiu
@@ -0,0 +1,612 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+// Safe memory reclamation policies shared by the containers of this library.
+//
+// A policy exposes:
+//     typename guard                   - RAII read-side protection, one pointer at a time
+//     static void retire(p, deleter)   - defer deleter(p) until no guard can reach p
+//     static void collect()            - try to reclaim this thread's retired objects now
+//     static constexpr bool covers_unlinked_nodes
+//                                      - true if a guard also keeps alive everything that
+//                                        is unlinked while it is held, so a reader may keep
+//                                        following links out of an unlinked node
+//
+// guard::set(p) publishes p and the caller must then re-read the link p was loaded
+// from; p is safe to dereference only if the link still holds it. guard::protect()
+// wraps that loop for plain std::atomic<N*> links.
+//
+// Guards are bound to the thread that created them and must not be handed over to
+// another thread.
+
+namespace hungbiu {
+
+namespace detail {
+
+// An object waiting to be reclaimed, with the function that destroys it
+struct retired_ptr
+{
+    void *m_ptr;
+    void (*m_deleter)(void *);
+
+    void reclaim() const noexcept {
+        m_deleter(m_ptr);
+    }
+};
+
+// Reclaim the tail [first, retired.end()) of retired. The doomed entries are
+// moved out first since a deleter may retire more objects. The buffer is
+// borrowed from spare, so steady-state scans do not allocate.
+template<typename Retired>
+void reclaim_tail( std::vector<Retired> &retired, 
+                   typename std::vector<Retired>::iterator first,
+                   std::vector<Retired> &spare)
+{
+    auto doomed = std::move(spare);
+    doomed.assign(first, retired.end());
+    retired.erase(first, retired.end());
+    for (auto &r : doomed) {
+        r.reclaim();
+    }
+    doomed.clear();
+    spare = std::move(doomed);
+}
+
+// Common protect() loop of the guards
+template<typename Guard>
+struct guard_base
+{
+    // Load src and protect its target. Returns nullptr without protection
+    // if src holds nullptr.
+    template<typename N>
+    N *protect(const std::atomic<N *> &src) {
+        auto &self = static_cast<Guard &>(*this);
+        auto p = src.load(std::memory_order_acquire);
+        for (;;) {
+            if (!p) {
+                self.reset();
+                return nullptr;
+            }
+            self.set(p);
+            auto q = src.load(std::memory_order_seq_cst);
+            if (q == p) {
+                return p;
+            }
+            p = q;
+        }
+    }
+};
+
+// Records of both domains live in a push-only list and are recycled through m_active
+template<typename Record>
+class record_list
+{
+private:
+    std::atomic<Record *> m_records{ nullptr };
+    std::atomic<size_t>   m_count{ 0 };
+public:
+    record_list() = default;
+    record_list(const record_list &) = delete;
+    record_list &operator= (const record_list &) = delete;
+
+    Record *head() const noexcept {
+        return m_records.load(std::memory_order_acquire);
+    }
+    size_t size() const noexcept {
+        return m_count.load(std::memory_order_relaxed);
+    }
+    // Take an inactive record or publish a new one
+    Record *acquire() {
+        for (auto r = head(); r; r = r->m_next) {
+            auto b = false;
+            if ( !r->m_active.load(std::memory_order_relaxed)
+                 && r->m_active.compare_exchange_strong(b, true, std::memory_order_acq_rel)) {
+                return r;
+            }
+        }
+        auto r = new Record;
+        r->m_active.store(true, std::memory_order_relaxed);
+        auto old_head = m_records.load(std::memory_order_relaxed);
+        do {
+            r->m_next = old_head;
+        } while (!m_records.compare_exchange_weak( old_head,
+                                                   r,
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed)) ;
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        return r;
+    }
+    void release(Record *r) noexcept {
+        r->m_active.store(false, std::memory_order_release);
+    }
+};
+
+// Objects retired by threads that exited before they could be reclaimed
+class orphanage
+{
+private:
+    std::mutex               m_mtx;
+    std::vector<retired_ptr> m_orphans;
+public:
+    template<typename Retired>
+    void give(std::vector<Retired> &retired) {
+        if (retired.empty()) {
+            return;
+        }
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        for (auto &r : retired) {
+            m_orphans.push_back(static_cast<const retired_ptr &>(r));
+        }
+        retired.clear();
+    }
+    // Move the orphans into retired without blocking on a concurrent adopter
+    template<typename Retired, typename Tag>
+    void adopt(std::vector<Retired> &retired, Tag tag) {
+        auto lock = std::unique_lock<std::mutex>{ m_mtx, std::try_to_lock };
+        if (!lock || m_orphans.empty()) {
+            return;
+        }
+        for (auto &r : m_orphans) {
+            retired.push_back(Retired{ r, tag });
+        }
+        m_orphans.clear();
+    }
+};
+
+// Hazard pointers (Michael, 2004)
+// --------------------------------------------------
+
+struct hazard_record
+{
+    std::atomic<const void *> m_ptr{ nullptr };
+    std::atomic<bool>         m_active{ false };
+    hazard_record            *m_next = nullptr;   // Immutable once published
+};
+
+struct hazard_retired : retired_ptr
+{
+    hazard_retired(const retired_ptr &r, int) : retired_ptr(r) {}
+    hazard_retired(void *p, void (*d)(void *)) : retired_ptr{ p, d } {}
+};
+
+class hazard_domain
+{
+private:
+    record_list<hazard_record> m_records;
+    orphanage                  m_orphans;
+public:
+    // Never destroyed: threads may still retire during static destruction
+    static hazard_domain &instance() {
+        static auto *domain = new hazard_domain;
+        return *domain;
+    }
+
+    hazard_record *acquire() {
+        return m_records.acquire();
+    }
+    void release(hazard_record *r) noexcept {
+        r->m_ptr.store(nullptr, std::memory_order_release);
+        m_records.release(r);
+    }
+    // Number of retired objects a thread may hold before scanning
+    size_t threshold() const noexcept {
+        return 2 * m_records.size() + 64;
+    }
+    // Reclaim every object of retired that no hazard pointer protects.
+    // hazards and spare are scratch buffers of the calling thread.
+    void scan( std::vector<hazard_retired> &retired,
+               std::vector<const void *> &hazards,
+               std::vector<hazard_retired> &spare) {
+        m_orphans.adopt(retired, 0);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        hazards.clear();
+        for (auto r = m_records.head(); r; r = r->m_next) {
+            if (auto p = r->m_ptr.load(std::memory_order_seq_cst)) {
+                hazards.push_back(p);
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        auto kept = std::partition( retired.begin(),
+                                    retired.end(),
+                                    [&hazards](const hazard_retired &r) {
+                                        return std::binary_search(hazards.begin(), hazards.end(), r.m_ptr);
+                                    });
+        reclaim_tail(retired, kept, spare);
+    }
+    void orphan(std::vector<hazard_retired> &retired) {
+        m_orphans.give(retired);
+    }
+};
+
+// Per-thread retired list and a cache of hazard records, large enough for
+// the guards a skip list search holds
+class hazard_thread_state
+{
+private:
+    static constexpr size_t CacheSize = 64;
+
+    std::vector<hazard_retired> m_retired;
+    std::vector<const void *>   m_hazards;      // Scratch buffers of scan()
+    std::vector<hazard_retired> m_spare;
+    hazard_record              *m_cache[CacheSize];
+    size_t                      m_cached = 0;
+public:
+    hazard_thread_state() = default;
+    hazard_thread_state(const hazard_thread_state &) = delete;
+    hazard_thread_state &operator= (const hazard_thread_state &) = delete;
+    ~hazard_thread_state() {
+        auto &domain = hazard_domain::instance();
+        while (m_cached) {
+            domain.release(m_cache[--m_cached]);
+        }
+        scan();
+        domain.orphan(m_retired);
+    }
+
+    static hazard_thread_state &local() {
+        thread_local hazard_thread_state state;
+        return state;
+    }
+
+    hazard_record *acquire() {
+        return m_cached ? m_cache[--m_cached]
+                        : hazard_domain::instance().acquire();
+    }
+    void release(hazard_record *r) noexcept {
+        if (m_cached < CacheSize) {
+            r->m_ptr.store(nullptr, std::memory_order_release);
+            m_cache[m_cached++] = r;
+        } else {
+            hazard_domain::instance().release(r);
+        }
+    }
+    void retire(void *p, void (*deleter)(void *)) {
+        m_retired.emplace_back(p, deleter);
+        auto &domain = hazard_domain::instance();
+        if (m_retired.size() >= domain.threshold()) {
+            scan();
+        }
+    }
+    void collect() {
+        scan();
+    }
+private:
+    void scan() {
+        hazard_domain::instance().scan(m_retired, m_hazards, m_spare);
+    }
+};
+
+// Epoch-based reclamation (Fraser, 2004)
+// --------------------------------------------------
+
+struct epoch_record
+{
+    std::atomic<uint64_t> m_state{ 0 };       // (epoch << 1) | pinned
+    std::atomic<bool>     m_active{ false };
+    epoch_record         *m_next = nullptr;   // Immutable once published
+};
+
+struct epoch_retired : retired_ptr
+{
+    uint64_t m_epoch;
+
+    epoch_retired(const retired_ptr &r, uint64_t e) : retired_ptr(r), m_epoch(e) {}
+    epoch_retired(void *p, void (*d)(void *), uint64_t e) : retired_ptr{ p, d }, m_epoch(e) {}
+};
+
+class epoch_domain
+{
+private:
+    std::atomic<uint64_t>     m_epoch{ 0 };
+    record_list<epoch_record> m_records;
+    orphanage                 m_orphans;
+public:
+    // Never destroyed: threads may still retire during static destruction
+    static epoch_domain &instance() {
+        static auto *domain = new epoch_domain;
+        return *domain;
+    }
+
+    uint64_t epoch() const noexcept {
+        return m_epoch.load(std::memory_order_seq_cst);
+    }
+    epoch_record *acquire() {
+        return m_records.acquire();
+    }
+    void release(epoch_record *r) noexcept {
+        r->m_state.store(0, std::memory_order_release);
+        m_records.release(r);
+    }
+    // Advance the global epoch if every pinned thread has observed it
+    void try_advance() noexcept {
+        auto e = epoch();
+        for (auto r = m_records.head(); r; r = r->m_next) {
+            auto s = r->m_state.load(std::memory_order_seq_cst);
+            if ((s & 1) && (s >> 1) != e) {
+                return;
+            }
+        }
+        m_epoch.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+    }
+    // Reclaim the objects retired at least two epochs ago.
+    // spare is a scratch buffer of the calling thread.
+    void scan(std::vector<epoch_retired> &retired, std::vector<epoch_retired> &spare) {
+        try_advance();
+        m_orphans.adopt(retired, epoch());
+        auto e = epoch();
+        auto kept = std::partition( retired.begin(),
+                                    retired.end(),
+                                    [e](const epoch_retired &r) {
+                                        return r.m_epoch + 2 > e;
+                                    });
+        reclaim_tail(retired, kept, spare);
+    }
+    void orphan(std::vector<epoch_retired> &retired) {
+        m_orphans.give(retired);
+    }
+};
+
+// Per-thread pin nesting and retired list. A scan runs once the list
+// has grown by ScanPeriod past twice what the last scan kept, so a thread
+// retiring many objects while pinned (e.g. a long remove_if()) does not
+// rescan the same unreclaimable objects over and over.
+class epoch_thread_state
+{
+private:
+    static constexpr size_t ScanPeriod = 64;
+
+    epoch_record              *m_record = nullptr;
+    size_t                     m_nesting = 0;
+    size_t                     m_scan_at = ScanPeriod;
+    std::vector<epoch_retired> m_retired;
+    std::vector<epoch_retired> m_spare;         // Scratch buffer of scan()
+public:
+    epoch_thread_state() = default;
+    epoch_thread_state(const epoch_thread_state &) = delete;
+    epoch_thread_state &operator= (const epoch_thread_state &) = delete;
+    ~epoch_thread_state() {
+        auto &domain = epoch_domain::instance();
+        if (m_record) {
+            domain.release(m_record);
+        }
+        scan();
+        domain.orphan(m_retired);
+    }
+
+    static epoch_thread_state &local() {
+        thread_local epoch_thread_state state;
+        return state;
+    }
+
+    void pin() {
+        if (m_nesting++) {
+            return;
+        }
+        auto &domain = epoch_domain::instance();
+        if (!m_record) {
+            m_record = domain.acquire();
+        }
+        m_record->m_state.store((domain.epoch() << 1) | 1, std::memory_order_seq_cst);
+    }
+    void unpin() noexcept {
+        if (!--m_nesting) {
+            m_record->m_state.store(0, std::memory_order_release);
+        }
+    }
+    void retire(void *p, void (*deleter)(void *)) {
+        auto &domain = epoch_domain::instance();
+        m_retired.emplace_back(p, deleter, domain.epoch());
+        if (m_retired.size() >= m_scan_at) {
+            scan();
+        }
+    }
+    void collect() {
+        scan();
+    }
+private:
+    void scan() {
+        epoch_domain::instance().scan(m_retired, m_spare);
+        m_scan_at = 2 * m_retired.size() + ScanPeriod;
+    }
+};
+
+} // end of namespace detail
+
+// Hazard pointer reclamation: a guard owns one hazard slot, so protection does
+// not stall reclamation of anything else, but a reader holding an unlinked node
+// cannot trust the links leaving it.
+struct hazard_pointer_reclaimer
+{
+    static constexpr bool covers_unlinked_nodes = false;
+
+    class guard : public detail::guard_base<guard>
+    {
+    private:
+        detail::hazard_record *m_rec = nullptr;
+    public:
+        guard() noexcept = default;
+        guard(const guard &) = delete;
+        guard(guard &&oth) noexcept :
+            m_rec(std::exchange(oth.m_rec, nullptr)) {}
+        guard &operator= (const guard &) = delete;
+        guard &operator= (guard &&rhs) noexcept {
+            if (this != &rhs) {
+                release();
+                m_rec = std::exchange(rhs.m_rec, nullptr);
+            }
+            return *this;
+        }
+        ~guard() {
+            release();
+        }
+
+        // Publish p as hazardous. The caller must validate p afterwards.
+        void set(const void *p) {
+            if (!m_rec) {
+                m_rec = detail::hazard_thread_state::local().acquire();
+            }
+            m_rec->m_ptr.store(p, std::memory_order_seq_cst);
+        }
+        // Drop the protection, keep the slot for the next set()
+        void reset() noexcept {
+            if (m_rec) {
+                m_rec->m_ptr.store(nullptr, std::memory_order_release);
+            }
+        }
+        void swap(guard &oth) noexcept {
+            std::swap(m_rec, oth.m_rec);
+        }
+    private:
+        void release() noexcept {
+            if (m_rec) {
+                detail::hazard_thread_state::local().release(m_rec);
+                m_rec = nullptr;
+            }
+        }
+    };
+
+    static void retire(void *p, void (*deleter)(void *)) {
+        detail::hazard_thread_state::local().retire(p, deleter);
+    }
+    static void collect() {
+        detail::hazard_thread_state::local().collect();
+    }
+};
+
+// Epoch-based reclamation: a guard pins the calling thread, which is cheap and
+// keeps every node it may reach alive, but a long-lived guard (e.g. an iterator
+// kept around) holds back reclamation for all threads.
+struct epoch_reclaimer
+{
+    static constexpr bool covers_unlinked_nodes = true;
+
+    class guard : public detail::guard_base<guard>
+    {
+    private:
+        bool m_pinned = false;
+    public:
+        guard() noexcept = default;
+        guard(const guard &) = delete;
+        guard(guard &&oth) noexcept :
+            m_pinned(std::exchange(oth.m_pinned, false)) {}
+        guard &operator= (const guard &) = delete;
+        guard &operator= (guard &&rhs) noexcept {
+            if (this != &rhs) {
+                reset();
+                m_pinned = std::exchange(rhs.m_pinned, false);
+            }
+            return *this;
+        }
+        ~guard() {
+            reset();
+        }
+
+        // Pin the thread. The caller must validate p afterwards.
+        void set(const void *) {
+            if (!m_pinned) {
+                detail::epoch_thread_state::local().pin();
+                m_pinned = true;
+            }
+        }
+        void reset() noexcept {
+            if (m_pinned) {
+                detail::epoch_thread_state::local().unpin();
+                m_pinned = false;
+            }
+        }
+        void swap(guard &oth) noexcept {
+            std::swap(m_pinned, oth.m_pinned);
+        }
+    };
+
+    static void retire(void *p, void (*deleter)(void *)) {
+        detail::epoch_thread_state::local().retire(p, deleter);
+    }
+    static void collect() {
+        detail::epoch_thread_state::local().collect();
+    }
+};
+
+// A worker thread that runs the deleters handed to it, so that tearing down
+// a large structure does not stall the thread dropping it. Deleters run on
+// the worker thread, one at a time, in submission order; whatever is still
+// queued at program exit runs before the worker is joined.
+class background_reclaimer
+{
+private:
+    std::mutex                       m_mtx;
+    std::condition_variable          m_cv;
+    std::vector<detail::retired_ptr> m_queue;
+    size_t                           m_pending = 0;    // Queued or running
+    bool                             m_stop = false;
+    std::thread                      m_thread;
+
+    background_reclaimer() :
+        m_thread([this] { run(); }) {}
+public:
+    background_reclaimer(const background_reclaimer &) = delete;
+    background_reclaimer &operator= (const background_reclaimer &) = delete;
+    ~background_reclaimer() {
+        {
+            auto lock = std::lock_guard<std::mutex>{ m_mtx };
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    static background_reclaimer &instance() {
+        static background_reclaimer worker;
+        return worker;
+    }
+
+    // Run deleter(p) on the worker thread
+    void defer(void *p, void (*deleter)(void *)) {
+        {
+            auto lock = std::lock_guard<std::mutex>{ m_mtx };
+            m_queue.push_back(detail::retired_ptr{ p, deleter });
+            ++m_pending;
+        }
+        m_cv.notify_all();
+    }
+    // Block until everything deferred so far has run
+    void drain() {
+        auto lock = std::unique_lock<std::mutex>{ m_mtx };
+        m_cv.wait(lock, [this] { return !m_pending; });
+    }
+private:
+    void run() {
+        auto batch = std::vector<detail::retired_ptr>{};
+        auto lock = std::unique_lock<std::mutex>{ m_mtx };
+        for (;;) {
+            m_cv.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;     // Stopped with nothing left
+            }
+            batch.swap(m_queue);
+            lock.unlock();
+            for (auto &r : batch) {
+                r.reclaim();
+            }
+            auto done = batch.size();
+            batch.clear();
+            lock.lock();
+            m_pending -= done;
+            if (!m_pending) {
+                m_cv.notify_all();
+            }
+        }
+    }
+};
+
+}; // end of namespace hungbiu
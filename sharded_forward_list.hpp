@@ -0,0 +1,164 @@
+#pragma once
+#include <memory>
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <functional>
+#include "concurrent_forward_list.hpp"
+#include "striped_counter.hpp"
+#include "cache_line.hpp"
+
+namespace hungbiu {
+
+// A set of concurrent_forward_list shards, one per thread by default.
+// A thread pushes to and pops from its home shard, picked by its
+// thread_index(), so producer/consumer pairs on the same thread never
+// touch another thread's head or nodes; a pop only steals from the other
+// shards, starting next to home, once the home shard is empty.
+//
+// There is no global order: elements are LIFO within a shard only, and
+// for_each() visits the shards one after another. Template parameters are
+// those of concurrent_forward_list.
+template<typename T,
+         typename Reclaimer = epoch_reclaimer,
+         typename Allocator = std::allocator<T>,
+         typename SyncPolicy = locking_policy,
+         typename Stats = no_stats,
+         typename Layout = compact_layout,
+         typename Versioning = unversioned_nodes>
+class sharded_forward_list
+{
+public:
+    typedef concurrent_forward_list<T, Reclaimer, Allocator, SyncPolicy, Stats, Layout, Versioning> list_type;
+    typedef T                                                            value_type;
+    typedef Allocator                                                    allocator_type;
+private:
+    // Heads of different shards do not share a cache line
+    struct alignas(detail::cache_line_size) shard
+    {
+        list_type m_list;
+    };
+
+    std::unique_ptr<shard[]> m_shards;
+    size_t                   m_count;
+
+    static size_t default_shards() noexcept {
+        auto n = std::thread::hardware_concurrency();
+        return n ? n : 1;
+    }
+    size_t home() const noexcept {
+        return detail::thread_index() % m_count;
+    }
+public:
+    // Constructor
+    explicit sharded_forward_list(size_t shards = default_shards()) :
+        m_shards(nullptr), m_count(shards)
+    {
+        if (shards == 0) {
+            throw std::runtime_error{ "sharded_forward_list: no shards" };
+        }
+        m_shards = std::make_unique<shard[]>(shards);
+    }
+    sharded_forward_list(const sharded_forward_list &) = delete;
+    sharded_forward_list &operator= (const sharded_forward_list &) = delete;
+
+    // Modifiers
+    void push_front(const T &val) {
+        m_shards[home()].m_list.push_front(val);
+    }
+    void push_front(T &&val) {
+        m_shards[home()].m_list.push_front(std::move(val));
+    }
+    template<typename... Args>
+    void emplace_front(Args&&... args) {
+        m_shards[home()].m_list.emplace_front(std::forward<Args>(args)...);
+    }
+    // Pop from the home shard, or steal from the others
+    // Returns std::nullopt if every shard was found empty
+    std::optional<T> try_pop_front() {
+        auto h = home();
+        for (size_t i = 0; i < m_count; ++i) {
+            if (auto v = m_shards[(h + i) % m_count].m_list.try_pop_front()) {
+                return v;
+            }
+        }
+        return std::nullopt;
+    }
+    // Returns a bool indicates if a value was moved into out
+    bool try_pop_front(T &out) {
+        auto h = home();
+        for (size_t i = 0; i < m_count; ++i) {
+            if (m_shards[(h + i) % m_count].m_list.try_pop_front(out)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    void clear() {
+        for (size_t i = 0; i < m_count; ++i) {
+            m_shards[i].m_list.clear();
+        }
+    }
+
+    // Traversal
+    // Apply f to every element, shard after shard, as
+    // concurrent_forward_list::for_each() does within each shard
+    template<typename F>
+    void for_each(F f) {
+        for (size_t i = 0; i < m_count; ++i) {
+            m_shards[i].m_list.for_each(std::ref(f));
+        }
+    }
+    template<typename F>
+    void for_each(F f) const {
+        for (size_t i = 0; i < m_count; ++i) {
+            std::as_const(m_shards[i].m_list).for_each(std::ref(f));
+        }
+    }
+
+    // Shards, e.g. to traverse one or drain them one by one
+    list_type &shard_at(size_t i) {
+        return m_shards[i].m_list;
+    }
+    const list_type &shard_at(size_t i) const {
+        return m_shards[i].m_list;
+    }
+    size_t shard_count() const noexcept {
+        return m_count;
+    }
+
+    // Capacity
+    bool empty() const noexcept {
+        for (size_t i = 0; i < m_count; ++i) {
+            if (!m_shards[i].m_list.empty()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Sums of the shards' counts, see concurrent_forward_list::size().
+    // size() is exact per shard, not across shards.
+    size_t approx_size() const noexcept {
+        auto n = size_t{ 0 };
+        for (size_t i = 0; i < m_count; ++i) {
+            n += m_shards[i].m_list.approx_size();
+        }
+        return n;
+    }
+    size_t size() const noexcept {
+        auto n = size_t{ 0 };
+        for (size_t i = 0; i < m_count; ++i) {
+            n += m_shards[i].m_list.size();
+        }
+        return n;
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return allocator_type{};
+    }
+};
+
+}; // end of namespace hungbiu
@@ -0,0 +1,90 @@
+#include "sharded_forward_list.hpp"
+#include <thread>
+#include <stdio.h>
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <vector>
+
+using namespace hungbiu;
+
+template<typename Reclaimer, typename SyncPolicy>
+void test_sharded(const char *name)
+{
+    printf("--- %s ---\n", name);
+    auto slist = sharded_forward_list<std::string, Reclaimer, std::allocator<std::string>, SyncPolicy>{ 4 };
+    assert(slist.shard_count() == 4 && slist.empty() && !slist.try_pop_front());
+
+    // LIFO within the home shard
+    slist.push_front("a");
+    slist.push_front(std::string{ "b" });
+    slist.emplace_front(2, 'c');
+    auto s = std::string{};
+    assert(*slist.try_pop_front() == "cc");
+    assert(slist.try_pop_front(s) && s == "b");
+    auto joined = std::string{};
+    slist.for_each([&](const std::string &v) { joined += v; });
+    assert(joined == "a");
+    printf("push_front(), try_pop_front(), for_each(): pass\n");
+
+    // Elements pushed by other threads are stolen
+    auto others = std::vector<std::thread>{};
+    for (auto i = 0; i < 3; ++i) {
+        others.emplace_back([&slist, i] { slist.push_front(std::to_string(i)); });
+    }
+    for (auto &t : others) {
+        t.join();
+    }
+    auto count = 0;
+    while (slist.try_pop_front(s)) {
+        ++count;
+    }
+    assert(count == 4 && slist.empty() && slist.size() == 0);
+    printf("steal: pass\n");
+
+    // Every pushed value is popped, stolen or left over, exactly once
+    auto ilist = sharded_forward_list<int, Reclaimer, std::allocator<int>, SyncPolicy>{};
+    constexpr auto Threads = 4;
+    constexpr auto Count = 20000;
+    std::atomic<long> popped_sum{ 0 };
+    auto producer = [&] {
+        for (auto i = 1; i <= Count; ++i) {
+            ilist.push_front(i);
+            if (i % 3 == 0) {
+                popped_sum.fetch_add(ilist.try_pop_front().value_or(0));
+            }
+        }
+    };
+    auto stealer = [&] {
+        auto v = 0;
+        for (auto i = 0; i < Count; ++i) {
+            if (ilist.try_pop_front(v)) {
+                popped_sum.fetch_add(v);
+            }
+        }
+    };
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < Threads; ++i) {
+        threads.emplace_back(producer);
+    }
+    threads.emplace_back(stealer);
+    for (auto &t : threads) {
+        t.join();
+    }
+    auto left_sum = 0l;
+    ilist.for_each([&](int v) { left_sum += v; });
+    assert(popped_sum.load() + left_sum == static_cast<long>(Threads) * Count * (Count + 1) / 2);
+    auto left = size_t{ 0 };
+    ilist.for_each([&](int) { ++left; });
+    assert(ilist.size() == left && ilist.approx_size() == left);
+    ilist.clear();
+    assert(ilist.empty());
+    printf("simultaneous push_front(), try_pop_front() and steals: pass\n");
+    Reclaimer::collect();
+}
+
+int main()
+{
+    test_sharded<epoch_reclaimer, locking_policy>("epoch_reclaimer, locking_policy");
+    test_sharded<hazard_pointer_reclaimer, lock_free_policy>("hazard_pointer_reclaimer, lock_free_policy");
+}
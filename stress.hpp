@@ -0,0 +1,245 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Randomized multi-threaded stress harness with a linearizability checker.
+// Threads run short rounds of random operations on a shared subject; every
+// operation is recorded with a logical clock reading before its call and
+// after its return. After each round the history is checked against a
+// sequential model, starting from the state the subject was left in by the
+// previous round: it must be explainable by some order of the operations
+// that respects their real-time order.
+
+namespace hungbiu {
+
+namespace stress {
+
+// One completed operation: what ran with which arguments, what it returned,
+// and the clock readings around the call
+struct event
+{
+    unsigned m_thread = 0;
+    unsigned m_op = 0;
+    int      m_arg = 0;
+    int      m_arg2 = 0;
+    int      m_result = 0;
+    uint64_t m_invoke = 0;
+    uint64_t m_response = 0;
+};
+
+// The most operations a round may record, one bit each in the checker
+constexpr size_t MaxHistory = 64;
+
+// Wing & Gong's search with Lowe's memoization: linearize, one at a time,
+// a pending operation invoked before every other pending one returned, if
+// the model accepts its result; backtrack on a dead end. A pair of
+// (linearized operations, model state) already explored is not explored
+// again, which keeps short histories cheap.
+// apply(state, e) applies e to state and returns whether the model
+// produces e's result. State must be copyable and ordered.
+template<typename State, typename Apply>
+class linearizability_checker
+{
+private:
+    const std::vector<event>          &m_history;
+    Apply                              m_apply;
+    uint64_t                           m_all;
+    std::set<std::pair<uint64_t, State>> m_explored;
+
+    bool search(uint64_t done, const State &s) {
+        if (done == m_all) {
+            return true;
+        }
+        if (!m_explored.emplace(done, s).second) {
+            return false;
+        }
+        auto first_response = UINT64_MAX;
+        for (size_t i = 0; i < m_history.size(); ++i) {
+            if (!(done >> i & 1)) {
+                first_response = std::min(first_response, m_history[i].m_response);
+            }
+        }
+        for (size_t i = 0; i < m_history.size(); ++i) {
+            if (done >> i & 1 || m_history[i].m_invoke > first_response) {
+                continue;
+            }
+            auto next = s;
+            if (m_apply(next, m_history[i]) && search(done | uint64_t{ 1 } << i, next)) {
+                return true;
+            }
+        }
+        return false;
+    }
+public:
+    linearizability_checker(const std::vector<event> &history, Apply apply) :
+        m_history(history), m_apply(std::move(apply)),
+        m_all(history.size() == MaxHistory ? ~uint64_t{ 0 } : (uint64_t{ 1 } << history.size()) - 1) {}
+
+    bool check(const State &initial) {
+        m_explored.clear();
+        return search(0, initial);
+    }
+};
+
+template<typename State, typename Apply>
+bool linearizable(const std::vector<event> &history, const State &initial, Apply apply)
+{
+    if (history.size() > MaxHistory) {
+        throw std::runtime_error{ "stress: history too long to check" };
+    }
+    return linearizability_checker<State, Apply>{ history, std::move(apply) }.check(initial);
+}
+
+// Command line: --threads N --duration MS --mix NAME --seed S
+struct options
+{
+    unsigned                  m_threads = std::max(8u, std::thread::hardware_concurrency());
+    std::chrono::milliseconds m_duration{ 100 };   // Per subject, mix and thread count
+    std::string               m_mix;                // Empty selects all
+    uint64_t                  m_seed = 1;
+
+    options(int argc, char **argv) {
+        for (auto i = 1; i + 1 < argc; i += 2) {
+            if (!strcmp(argv[i], "--threads")) {
+                m_threads = static_cast<unsigned>(atoi(argv[i + 1]));
+            } else if (!strcmp(argv[i], "--duration")) {
+                m_duration = std::chrono::milliseconds{ atoi(argv[i + 1]) };
+            } else if (!strcmp(argv[i], "--mix")) {
+                m_mix = argv[i + 1];
+            } else if (!strcmp(argv[i], "--seed")) {
+                m_seed = strtoull(argv[i + 1], nullptr, 10);
+            }
+        }
+        if (!m_threads) {
+            m_threads = 1;
+        }
+    }
+    bool wants_mix(const char *name) const {
+        return m_mix.empty() || m_mix == name;
+    }
+    // 1, 2, 4, ... up to m_threads
+    std::vector<unsigned> thread_counts() const {
+        auto counts = std::vector<unsigned>{};
+        for (auto n = 1u; n < m_threads; n *= 2) {
+            counts.push_back(n);
+        }
+        counts.push_back(m_threads);
+        return counts;
+    }
+};
+
+struct run_result
+{
+    size_t m_rounds = 0;
+    size_t m_ops = 0;
+    bool   m_linearizable = true;
+};
+
+// Run rounds on subject with threads threads until duration passed, or
+// until a round's history is not linearizable; that history is printed.
+// Model supplies, as static members:
+//     typedef ... state_type;
+//     state_type observe(const Subject &);     the quiescent subject's state
+//     void pick(std::mt19937_64 &, const state_type &, int fresh, event &);
+//                                              choose m_op and its arguments,
+//                                              fresh is a value never used yet
+//     void perform(Subject &, event &);        run it, set m_result
+//     bool apply(state_type &, const event &); the sequential model
+//     const char *name_of(unsigned op);
+template<typename Model, typename Subject>
+run_result run(Subject &subject, unsigned threads, std::chrono::milliseconds duration, uint64_t seed)
+{
+    if (!threads || threads > MaxHistory) {
+        throw std::runtime_error{ "stress: invalid thread count" };
+    }
+    const auto ops_per_thread = static_cast<unsigned>(std::max<size_t>(1, MaxHistory / threads));
+
+    auto clock = std::atomic<uint64_t>{ 0 };
+    auto round = std::atomic<size_t>{ 0 };
+    auto finished = std::atomic<unsigned>{ 0 };
+    auto stop = std::atomic<bool>{ false };
+    auto state = Model::observe(subject);
+    auto logs = std::vector<std::vector<event>>(threads);
+    auto fresh = std::atomic<int>{ 1 << 20 };
+
+    auto worker = [&](unsigned idx) {
+        auto rng = std::mt19937_64{ seed * 0x9e3779b97f4a7c15ull + idx };
+        for (size_t seen = 0; ; ) {
+            while (round.load(std::memory_order_acquire) == seen) {
+                if (stop.load(std::memory_order_acquire)) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            ++seen;
+            auto &log = logs[idx];
+            log.clear();
+            for (auto j = 0u; j < ops_per_thread; ++j) {
+                auto e = event{};
+                e.m_thread = idx;
+                Model::pick(rng, state, fresh.fetch_add(1, std::memory_order_relaxed), e);
+                e.m_invoke = clock.fetch_add(1, std::memory_order_seq_cst);
+                Model::perform(subject, e);
+                e.m_response = clock.fetch_add(1, std::memory_order_seq_cst);
+                log.push_back(e);
+            }
+            finished.fetch_add(1, std::memory_order_acq_rel);
+        }
+    };
+
+    auto pool = std::vector<std::thread>{};
+    for (auto i = 0u; i < threads; ++i) {
+        pool.emplace_back(worker, i);
+    }
+    auto result = run_result{};
+    auto history = std::vector<event>{};
+    auto deadline = std::chrono::steady_clock::now() + duration;
+    do {
+        finished.store(0, std::memory_order_relaxed);
+        round.fetch_add(1, std::memory_order_acq_rel);
+        while (finished.load(std::memory_order_acquire) != threads) {
+            std::this_thread::yield();
+        }
+        history.clear();
+        for (auto &log : logs) {
+            history.insert(history.end(), log.begin(), log.end());
+        }
+        ++result.m_rounds;
+        result.m_ops += history.size();
+        if (!linearizable(history, state, &Model::apply)) {
+            result.m_linearizable = false;
+            std::sort(history.begin(), history.end(),
+                      [](const event &a, const event &b) { return a.m_invoke < b.m_invoke; });
+            printf("not linearizable, from a state of %zu elements:\n", state.size());
+            for (auto &e : history) {
+                printf( "  [%llu, %llu] thread %u: %s(%d, %d) -> %d\n",
+                        static_cast<unsigned long long>(e.m_invoke),
+                        static_cast<unsigned long long>(e.m_response),
+                        e.m_thread, Model::name_of(e.m_op), e.m_arg, e.m_arg2, e.m_result );
+            }
+            break;
+        }
+        state = Model::observe(subject);
+    } while (std::chrono::steady_clock::now() < deadline);
+    stop.store(true, std::memory_order_release);
+    for (auto &t : pool) {
+        t.join();
+    }
+    return result;
+}
+
+} // end of namespace stress
+
+}; // end of namespace hungbiu
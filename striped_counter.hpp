@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <new>
+#include <thread>
+#include "cache_line.hpp"
+
+namespace hungbiu {
+
+namespace detail {
+
+// A small, dense number for the calling thread, handed out in the order
+// threads first ask for one
+inline unsigned thread_index() noexcept
+{
+    static std::atomic<unsigned> next{ 0 };
+    thread_local auto index = next.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+// A counter spread over cache-line sized stripes, one picked per thread,
+// so that concurrent updates do not bounce a single line around. Each
+// stripe counts additions and removals separately: both totals only grow,
+// which lets exact() take a consistent snapshot by double collect.
+// The first thread to update owns an inline stripe; the others' stripes,
+// one per hardware thread (at most MaxStripes), are allocated when a
+// second thread first updates, so a counter only one thread updates takes
+// one cache line.
+class striped_counter
+{
+private:
+    static constexpr size_t   MaxStripes = 32;
+    static constexpr unsigned NoOwner = ~0u;
+
+    struct alignas(cache_line_size) stripe
+    {
+        std::atomic<size_t> m_added{ 0 };
+        std::atomic<size_t> m_removed{ 0 };
+    };
+
+    stripe                m_first;
+    std::atomic<unsigned> m_owner{ NoOwner };       // thread_index() of m_first's thread
+    std::atomic<stripe *> m_stripes{ nullptr };
+    size_t                m_count;
+
+    static size_t default_stripes() noexcept {
+        auto n = static_cast<size_t>(std::thread::hardware_concurrency());
+        return n == 0 ? 1 : n < MaxStripes ? n : MaxStripes;
+    }
+    stripe &local() noexcept {
+        auto idx = thread_index();
+        auto owner = m_owner.load(std::memory_order_relaxed);
+        if ( owner == idx ||
+             (owner == NoOwner && m_owner.compare_exchange_strong(owner, idx, std::memory_order_relaxed)) ) {
+            return m_first;
+        }
+        auto stripes = m_stripes.load(std::memory_order_acquire);
+        if (!stripes) {
+            stripes = allocate_stripes();
+            if (!stripes) {
+                return m_first;     // Out of memory: share the owner's stripe
+            }
+        }
+        return stripes[idx % m_count];
+    }
+    // Returns the stripes installed, or nullptr if none could be allocated
+    stripe *allocate_stripes() noexcept {
+        auto stripes = new (std::nothrow) stripe[m_count];
+        if (!stripes) {
+            return m_stripes.load(std::memory_order_acquire);
+        }
+        auto expected = static_cast<stripe *>(nullptr);
+        if (!m_stripes.compare_exchange_strong(expected, stripes, std::memory_order_acq_rel)) {
+            delete[] stripes;
+            return expected;
+        }
+        return stripes;
+    }
+    // Sum of both totals over all stripes
+    void collect(size_t &added, size_t &removed, std::memory_order order) const noexcept {
+        added = m_first.m_added.load(order);
+        removed = m_first.m_removed.load(order);
+        auto stripes = m_stripes.load(std::memory_order_acquire);
+        if (!stripes) {
+            return;
+        }
+        for (size_t i = 0; i < m_count; ++i) {
+            added += stripes[i].m_added.load(order);
+            removed += stripes[i].m_removed.load(order);
+        }
+    }
+    static size_t difference(size_t added, size_t removed) noexcept {
+        // A removal may be counted before the addition it undoes
+        return added > removed ? added - removed : 0;
+    }
+public:
+    // Constructor
+    striped_counter() noexcept : m_count(default_stripes()) {}
+    striped_counter(const striped_counter &) = delete;
+    striped_counter &operator= (const striped_counter &) = delete;
+    ~striped_counter() {
+        delete[] m_stripes.load(std::memory_order_relaxed);
+    }
+
+    void add(size_t n) noexcept {
+        local().m_added.fetch_add(n, std::memory_order_relaxed);
+    }
+    void sub(size_t n) noexcept {
+        local().m_removed.fetch_add(n, std::memory_order_relaxed);
+    }
+    // Whether a second thread updated the counter, which allocated the
+    // stripes
+    bool is_striped() const noexcept {
+        return m_stripes.load(std::memory_order_acquire) != nullptr;
+    }
+
+    // One relaxed pass, may mix updates from different moments
+    size_t approx() const noexcept {
+        size_t added, removed;
+        collect(added, removed, std::memory_order_relaxed);
+        return difference(added, removed);
+    }
+    // Collect until two passes agree: the totals then held together
+    // between the passes. Lock-free, a pass only fails when updates
+    // completed meanwhile.
+    size_t exact() const noexcept {
+        size_t added, removed;
+        collect(added, removed, std::memory_order_seq_cst);
+        for (;;) {
+            size_t added2, removed2;
+            collect(added2, removed2, std::memory_order_seq_cst);
+            if (added2 == added && removed2 == removed) {
+                return difference(added, removed);
+            }
+            added = added2;
+            removed = removed2;
+        }
+    }
+};
+
+} // end of namespace detail
+
+}; // end of namespace hungbiu
@@ -0,0 +1,163 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace hungbiu {
+
+namespace detail {
+
+// Hint the CPU that we are spinning
+inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Exponential backoff for spin loops: spin for 1, 2, 4, ... pauses, then
+// fall back to yielding the time slice
+class backoff
+{
+private:
+    static constexpr unsigned SpinLimit = 6;
+    unsigned m_count = 0;
+public:
+    void pause() noexcept {
+        if (m_count < SpinLimit) {
+            for (auto i = 0u; i < (1u << m_count); ++i) {
+                cpu_relax();
+            }
+            ++m_count;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    void reset() noexcept {
+        m_count = 0;
+    }
+};
+
+// The link from a node to its successor, packed into one word together with
+// the node's lock bit and deleted mark:
+//
+//     | successor pointer ... | deleted | locked |
+//
+// The lock bit makes the link a BasicLockable spinlock, so it can be used with
+// std::unique_lock. While it is held, the successor and the deleted mark only
+// change through the holder; readers just load the word.
+//
+// Lock-free users leave the lock bit alone and CAS the word instead. The
+// deleted mark is then a Harris mark: once set, the link is frozen, and the
+// node waits to be unlinked by whoever CASes its predecessor.
+template<typename Node>
+class tagged_link
+{
+public:
+    typedef std::uintptr_t word_t;
+
+    static constexpr word_t LockBit    = 1;
+    static constexpr word_t DeletedBit = 2;
+    static constexpr word_t TagMask    = LockBit | DeletedBit;
+private:
+    std::atomic<word_t> m_word;
+public:
+    // Constructor
+    explicit tagged_link(Node *p = nullptr) noexcept :
+        m_word(to_word(p)) {}
+    tagged_link(const tagged_link &) = delete;
+    tagged_link &operator= (const tagged_link &) = delete;
+
+    // Decode a loaded word
+    static Node *pointer_of(word_t w) noexcept {
+        return reinterpret_cast<Node *>(w & ~TagMask);
+    }
+    static bool is_deleted(word_t w) noexcept {
+        return w & DeletedBit;
+    }
+    static bool is_locked(word_t w) noexcept {
+        return w & LockBit;
+    }
+    // True if both words link to the same successor with the same mark
+    static bool same_link(word_t a, word_t b) noexcept {
+        return (a & ~LockBit) == (b & ~LockBit);
+    }
+
+    word_t load(std::memory_order order = std::memory_order_acquire) const noexcept {
+        return m_word.load(order);
+    }
+    Node *next() const noexcept {
+        return pointer_of(load());
+    }
+    bool is_deleted() const noexcept {
+        return is_deleted(load());
+    }
+
+    // BasicLockable
+    void lock() noexcept {
+        auto b = backoff{};
+        while (!try_lock()) {
+            b.pause();
+        }
+    }
+    bool try_lock() noexcept {
+        auto w = m_word.load(std::memory_order_relaxed);
+        return !is_locked(w)
+               && m_word.compare_exchange_weak( w,
+                                                w | LockBit,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed);
+    }
+    void unlock() noexcept {
+        m_word.store(m_word.load(std::memory_order_relaxed) & ~LockBit,
+                     std::memory_order_release);
+    }
+
+    // Modifiers, the lock must be held
+    void set_next(Node *p) noexcept {
+        auto tags = m_word.load(std::memory_order_relaxed) & TagMask;
+        m_word.store(to_word(p) | tags, std::memory_order_release);
+    }
+    // Return true only if the node was not marked yet
+    bool mark_as_deleted() noexcept {
+        auto w = m_word.load(std::memory_order_relaxed);
+        if (is_deleted(w)) {
+            return false;
+        }
+        m_word.store(w | DeletedBit, std::memory_order_release);
+        return true;
+    }
+
+    // Lock-free modifiers, on failure expected receives the current word
+    // Link to p if the word is still expected
+    bool compare_exchange(word_t &expected, Node *p) noexcept {
+        return m_word.compare_exchange_strong( expected,
+                                               to_word(p),
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_acquire);
+    }
+    // Set the deleted mark if the word is still expected (and unmarked)
+    bool try_mark(word_t &expected) noexcept {
+        return m_word.compare_exchange_strong( expected,
+                                               expected | DeletedBit,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_acquire);
+    }
+
+    // Set the successor of a node not published yet
+    void init(Node *p) noexcept {
+        m_word.store(to_word(p), std::memory_order_relaxed);
+    }
+    static word_t to_word(Node *p) noexcept {
+        return reinterpret_cast<word_t>(p);
+    }
+};
+
+} // end of namespace detail
+
+}; // end of namespace hungbiu
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "tagged_link.hpp"  // detail::backoff
+
+// Birth and death stamps for the nodes of lists that take snapshots (see
+// concurrent_forward_list::snapshot()). A node is stamped from the version
+// clock when it is created and when it is marked deleted; a snapshot taken
+// at version v sees the nodes born at or before v and not dead by then.
+// Both stamps are read from the clock before the node is published or
+// marked, so a thread that saw either happen takes later snapshots at
+// versions no smaller than the stamp.
+
+namespace hungbiu {
+
+namespace detail {
+
+// The clock snapshots take their versions from, shared by all lists
+inline std::atomic<uint64_t> &version_clock() noexcept
+{
+    static std::atomic<uint64_t> clock{ 1 };
+    return clock;
+}
+
+template<bool Versioned>
+struct version_stamps {};
+
+template<>
+struct version_stamps<true>
+{
+    static constexpr uint64_t Unstamped = ~uint64_t{ 0 };
+
+    std::atomic<uint64_t> m_birth{ Unstamped };
+    std::atomic<uint64_t> m_death{ Unstamped };
+
+    // Before the node is published
+    void stamp_birth() noexcept {
+        m_birth.store(version_clock().load(std::memory_order_seq_cst), std::memory_order_relaxed);
+    }
+    // A marker reads the clock before every attempt to mark the node...
+    static uint64_t death_clock() noexcept {
+        return version_clock().load(std::memory_order_seq_cst);
+    }
+    // ...and the one that marked it stores its reading, losers do not
+    void stamp_death(uint64_t death) noexcept {
+        m_death.store(death, std::memory_order_release);
+    }
+    // A node seen marked but not stamped yet is between its marker's CAS
+    // and store, wait for the stamp rather than guess
+    bool alive_at(uint64_t v, bool marked) const noexcept {
+        if (m_birth.load(std::memory_order_relaxed) > v) {
+            return false;
+        }
+        if (!marked) {
+            return true;
+        }
+        auto b = backoff{};
+        auto death = m_death.load(std::memory_order_acquire);
+        for (; death == Unstamped; death = m_death.load(std::memory_order_acquire)) {
+            b.pause();
+        }
+        return death > v;
+    }
+};
+
+// Per-list count of the snapshots being taken, and of erasures that
+// unlinked nodes meanwhile, which may have hidden a node from them
+template<bool Versioned>
+struct snapshot_state {};
+
+template<>
+struct snapshot_state<true>
+{
+    std::atomic<size_t> m_open{ 0 };
+    std::atomic<size_t> m_late_unlinks{ 0 };
+};
+
+} // end of namespace detail
+
+}; // end of namespace hungbiu
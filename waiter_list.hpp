@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// Awaitable pops need C++20 coroutines
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define HUNGBIU_COROUTINES 1
+#endif
+
+namespace hungbiu {
+
+namespace detail {
+
+// Threads and coroutines parked until an element arrives, in FIFO order.
+// A producer calls notify() after publishing; unless someone is queued
+// that is one load of m_count. A consumer queues up through
+// enqueue_unless(), which retries the consumer's attempt with the waiter
+// already counted, so a producer publishing meanwhile either sees the
+// count or has its element found by the retry.
+class waiter_list
+{
+public:
+    struct waiter
+    {
+        waiter *m_prev = nullptr;
+        waiter *m_next = nullptr;
+        bool    m_queued = false;
+        bool    m_notified = false;
+        // A blocked thread is notified through m_cv, under the list's lock.
+        // Otherwise m_resume(m_arg) is called once the lock is released.
+        std::condition_variable *m_cv = nullptr;
+        void                   (*m_resume)(void *) = nullptr;
+        void                    *m_arg = nullptr;
+    };
+private:
+    std::atomic<size_t> m_count{ 0 };
+    std::mutex          m_mtx;
+    waiter             *m_first = nullptr;
+    waiter             *m_last = nullptr;
+public:
+    waiter_list() = default;
+    waiter_list(const waiter_list &) = delete;
+    waiter_list &operator= (const waiter_list &) = delete;
+
+    // Queue w, then run attempt(); if it succeeds, w leaves the queue
+    // again before anyone can notify it.
+    // Returns the result of attempt
+    template<typename Attempt>
+    bool enqueue_unless(waiter &w, Attempt attempt) {
+        auto lock = std::unique_lock<std::mutex>{ m_mtx };
+        push_back(w);
+        m_count.fetch_add(1, std::memory_order_seq_cst);
+        // Pairs with the producer's seq_cst publish and load of m_count
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!attempt()) {
+            return false;
+        }
+        unlink(w);
+        return true;
+    }
+    // Block until w, queued with a condition variable, is notified
+    // Returns false if the deadline passed first, w is then dequeued
+    template<typename Clock, typename Duration>
+    bool wait_until(waiter &w, const std::chrono::time_point<Clock, Duration> &deadline) {
+        auto lock = std::unique_lock<std::mutex>{ m_mtx };
+        if (w.m_cv->wait_until(lock, deadline, [&w] { return w.m_notified; })) {
+            return true;
+        }
+        unlink(w);
+        return false;
+    }
+    // Wake up to n waiters, the longest queued first
+    void notify(size_t n = 1) {
+        while (n-- && m_count.load(std::memory_order_seq_cst)) {
+            auto lock = std::unique_lock<std::mutex>{ m_mtx };
+            auto w = m_first;
+            if (!w) {
+                return;
+            }
+            unlink(*w);
+            w->m_notified = true;
+            if (w->m_cv) {
+                w->m_cv->notify_one();
+            } else {
+                auto resume = w->m_resume;
+                auto arg = w->m_arg;
+                lock.unlock();
+                resume(arg);
+            }
+        }
+    }
+    bool has_waiters() const noexcept {
+        return m_count.load(std::memory_order_seq_cst) != 0;
+    }
+private:
+    // The lock must be held
+    void push_back(waiter &w) noexcept {
+        w.m_prev = m_last;
+        w.m_next = nullptr;
+        w.m_queued = true;
+        w.m_notified = false;
+        if (m_last) {
+            m_last->m_next = &w;
+        } else {
+            m_first = &w;
+        }
+        m_last = &w;
+    }
+    void unlink(waiter &w) noexcept {
+        if (!w.m_queued) {
+            return;
+        }
+        (w.m_prev ? w.m_prev->m_next : m_first) = w.m_next;
+        (w.m_next ? w.m_next->m_prev : m_last) = w.m_prev;
+        w.m_prev = w.m_next = nullptr;
+        w.m_queued = false;
+        m_count.fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+} // end of namespace detail
+
+}; // end of namespace hungbiu
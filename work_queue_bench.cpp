@@ -0,0 +1,199 @@
+#include "bounded_mpmc_queue.hpp"
+#include "concurrent_forward_list.hpp"
+#include "concurrent_queue.hpp"
+#include "sharded_forward_list.hpp"
+#include "node_pool.hpp"
+#include "benchmark.hpp"
+#include <deque>
+#include <memory>
+#include <mutex>
+
+using namespace hungbiu;
+
+// The containers used as a work queue: every subject pushes and pops
+// single ints and batches of them
+constexpr auto PrefillCount = 1000;
+constexpr auto Capacity = 4096;
+constexpr auto BatchSize = 16;
+
+class mpmc_queue_subject
+{
+private:
+    bounded_mpmc_queue<int> m_queue{ Capacity };
+public:
+    void push(int v) {
+        m_queue.try_push(v);
+    }
+    void push_batch(const int *first, const int *last) {
+        m_queue.try_push_range(first, last);
+    }
+    void pop() {
+        auto v = 0;
+        bench::do_not_optimize(m_queue.try_pop(v));
+    }
+    void pop_batch() {
+        int batch[BatchSize];
+        bench::do_not_optimize(m_queue.try_pop_n(batch, BatchSize));
+    }
+};
+
+template<typename Queue>
+class cqueue_subject
+{
+private:
+    Queue m_queue;
+public:
+    void push(int v) {
+        m_queue.push(v);
+    }
+    void push_batch(const int *first, const int *last) {
+        for (; first != last; ++first) {
+            m_queue.push(*first);
+        }
+    }
+    void pop() {
+        bench::do_not_optimize(m_queue.try_pop());
+    }
+    void pop_batch() {
+        for (auto i = 0; i < BatchSize; ++i) {
+            pop();
+        }
+    }
+};
+
+template<typename List>
+class cflist_subject
+{
+private:
+    List m_list;
+public:
+    void push(int v) {
+        m_list.push_front(v);
+    }
+    void push_batch(const int *first, const int *last) {
+        m_list.push_front_range(first, last);
+    }
+    void pop() {
+        bench::do_not_optimize(m_list.try_pop_front());
+    }
+    void pop_batch() {
+        for (auto i = 0; i < BatchSize; ++i) {
+            pop();
+        }
+    }
+};
+
+template<typename List>
+class sharded_subject
+{
+private:
+    List m_list;
+public:
+    void push(int v) {
+        m_list.push_front(v);
+    }
+    void push_batch(const int *first, const int *last) {
+        for (; first != last; ++first) {
+            m_list.push_front(*first);
+        }
+    }
+    void pop() {
+        bench::do_not_optimize(m_list.try_pop_front());
+    }
+    void pop_batch() {
+        for (auto i = 0; i < BatchSize; ++i) {
+            pop();
+        }
+    }
+};
+
+// Baseline: std::deque behind one std::mutex
+class locked_deque_subject
+{
+private:
+    std::mutex      m_mtx;
+    std::deque<int> m_queue;
+public:
+    void push(int v) {
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        m_queue.push_back(v);
+    }
+    void push_batch(const int *first, const int *last) {
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        m_queue.insert(m_queue.end(), first, last);
+    }
+    void pop() {
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        if (!m_queue.empty()) {
+            m_queue.pop_front();
+        }
+    }
+    void pop_batch() {
+        auto lock = std::lock_guard<std::mutex>{ m_mtx };
+        for (auto i = 0; i < BatchSize && !m_queue.empty(); ++i) {
+            m_queue.pop_front();
+        }
+    }
+};
+
+template<typename Subject>
+std::vector<bench::mix<Subject>> mixes()
+{
+    typedef bench::operation<Subject> op;
+    auto push = op{ "push", 1, [](Subject &s, std::mt19937_64 &rng, unsigned) {
+        s.push(static_cast<int>(rng() & 0xffff));
+    } };
+    auto pop = op{ "pop", 1, [](Subject &s, std::mt19937_64 &, unsigned) {
+        s.pop();
+    } };
+    auto push_batch = op{ "push_batch", 1, [](Subject &s, std::mt19937_64 &rng, unsigned) {
+        int batch[BatchSize];
+        for (auto &v : batch) {
+            v = static_cast<int>(rng() & 0xffff);
+        }
+        s.push_batch(batch, batch + BatchSize);
+    } };
+    auto pop_batch = op{ "pop_batch", 1, [](Subject &s, std::mt19937_64 &, unsigned) {
+        s.pop_batch();
+    } };
+    return {
+        { "push_pop",       { push, pop } },
+        { "batch_push_pop", { push_batch, pop_batch } },
+    };
+}
+
+template<typename Subject>
+void run_subject(const char *name, const bench::options &opts)
+{
+    if (!opts.wants_subject(name)) {
+        return;
+    }
+    for (auto &m : mixes<Subject>()) {
+        if (!opts.wants_mix(m.m_name)) {
+            continue;
+        }
+        for (auto threads : opts.thread_counts()) {
+            auto subject = std::make_unique<Subject>();
+            for (auto i = 0; i < PrefillCount; ++i) {
+                subject->push(i);
+            }
+            auto r = bench::run(*subject, m, threads, opts.m_duration);
+            bench::print_result(name, m.m_name, threads, r);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    auto opts = bench::options{ argc, argv };
+    bench::print_header();
+    run_subject<locked_deque_subject>("mutex+std::deque", opts);
+    run_subject<cflist_subject<concurrent_forward_list<int, epoch_reclaimer, std::allocator<int>, lock_free_policy>>>(
+        "cflist<lock_free,epoch>", opts);
+    run_subject<cqueue_subject<concurrent_queue<int, epoch_reclaimer>>>("cqueue<epoch>", opts);
+    run_subject<cqueue_subject<concurrent_queue<int, hazard_pointer_reclaimer>>>("cqueue<hazard>", opts);
+    run_subject<cqueue_subject<concurrent_queue<int, epoch_reclaimer, node_pool_allocator<int>>>>("cqueue<epoch,pool>", opts);
+    run_subject<sharded_subject<sharded_forward_list<int, epoch_reclaimer, std::allocator<int>, lock_free_policy>>>(
+        "sharded<lock_free,epoch>", opts);
+    run_subject<mpmc_queue_subject>("bounded_mpmc_queue", opts);
+}